@@ -0,0 +1,454 @@
+#include <stdio.h>
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+#include <napys.h>
+
+#include "napys_internal.h"
+
+#define BENCH_INPUT_SIZE (4 * 1024 * 1024)
+#define BENCH_MIN_DURATION_NS (SDL_NS_PER_SECOND / 2)
+#define BENCH_MAX_RESULTS 32
+
+#ifndef NAPYS_BENCH_FONT_PATH
+#define NAPYS_BENCH_FONT_PATH "Roboto.ttf"
+#endif
+
+typedef void (*BenchFunc)(void *userdata);
+
+typedef enum
+{
+    BENCH_FORMAT_TABLE,
+    BENCH_FORMAT_CSV,
+    BENCH_FORMAT_JSON
+} BenchFormat;
+
+typedef struct
+{
+    const char *name;
+    Uint64 iterations;
+    double ns_per_op;
+    double allocs_per_op;
+    double mb_per_second; ///< 0 for benchmarks that do not process a byte stream.
+} BenchResult;
+
+static BenchResult bench_results[BENCH_MAX_RESULTS];
+static int bench_results_count = 0;
+
+// Every allocation made through SDL, including the ones of SDL_ttf and Napys, is counted
+static SDL_malloc_func original_malloc;
+static SDL_calloc_func original_calloc;
+static SDL_realloc_func original_realloc;
+static SDL_free_func original_free;
+static Uint64 allocations = 0;
+
+static void *SDLCALL CountingMalloc(size_t size)
+{
+    allocations++;
+    return original_malloc(size);
+}
+
+static void *SDLCALL CountingCalloc(size_t count, size_t size)
+{
+    allocations++;
+    return original_calloc(count, size);
+}
+
+static void *SDLCALL CountingRealloc(void *mem, size_t size)
+{
+    allocations++;
+    return original_realloc(mem, size);
+}
+
+static void SDLCALL CountingFree(void *mem)
+{
+    original_free(mem);
+}
+
+/**
+ * Run the function repeatedly for at least BENCH_MIN_DURATION_NS and record its cost per operation.
+ */
+static void RunBench(const char *name, BenchFunc func, void *userdata, size_t bytes_per_op)
+{
+    // Warm up caches and lazily initialized state
+    func(userdata);
+
+    Uint64 iterations = 0;
+    const Uint64 start_allocations = allocations;
+    const Uint64 start = SDL_GetTicksNS();
+    Uint64 elapsed = 0;
+
+    do
+    {
+        func(userdata);
+        iterations++;
+        elapsed = SDL_GetTicksNS() - start;
+    } while (elapsed < BENCH_MIN_DURATION_NS);
+
+    if (bench_results_count >= BENCH_MAX_RESULTS)
+    {
+        return;
+    }
+
+    const double seconds = (double)elapsed / SDL_NS_PER_SECOND;
+
+    BenchResult *result = &bench_results[bench_results_count++];
+    result->name = name;
+    result->iterations = iterations;
+    result->ns_per_op = (double)elapsed / iterations;
+    result->allocs_per_op = (double)(allocations - start_allocations) / iterations;
+    result->mb_per_second = (double)bytes_per_op * iterations / (1024.0 * 1024.0) / seconds;
+}
+
+static void PrintResults(BenchFormat format)
+{
+    if (format == BENCH_FORMAT_CSV)
+    {
+        printf("name,iterations,ns_per_op,allocs_per_op,mb_per_second\n");
+    }
+    else if (format == BENCH_FORMAT_JSON)
+    {
+        printf("[\n");
+    }
+    else
+    {
+        printf("%-32s %12s %12s %12s\n", "benchmark", "ns/op", "allocs/op", "MB/s");
+    }
+
+    for (int i = 0; i < bench_results_count; i++)
+    {
+        const BenchResult *result = &bench_results[i];
+
+        if (format == BENCH_FORMAT_CSV)
+        {
+            printf("%s,%llu,%.1f,%.2f,%.1f\n", result->name, (unsigned long long)result->iterations, result->ns_per_op,
+                   result->allocs_per_op, result->mb_per_second);
+        }
+        else if (format == BENCH_FORMAT_JSON)
+        {
+            printf("  {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, "
+                   "\"mb_per_second\": %.1f}%s\n",
+                   result->name, (unsigned long long)result->iterations, result->ns_per_op, result->allocs_per_op,
+                   result->mb_per_second, i + 1 < bench_results_count ? "," : "");
+        }
+        else
+        {
+            printf("%-32s %12.0f %12.2f %12.1f\n", result->name, result->ns_per_op, result->allocs_per_op,
+                   result->mb_per_second);
+        }
+    }
+
+    if (format == BENCH_FORMAT_JSON)
+    {
+        printf("]\n");
+    }
+}
+
+/**
+ * Build a large rich text input, with a tag roughly every tag_spacing bytes of plain text.
+ */
+static char *GenerateRichText(size_t size, size_t tag_spacing, bool with_newlines)
+{
+    static const char *tags[] = {"{{color:red}}", "{{size:small}}", "{{font:main}}", "{{image:icon}}", "{{welcome}}", "{{:newline}}"};
+    static const char *words[] = {"lorem ", "ipsum ", "dolor ", "sit ", "amet, ", "consectetur ", "adipiscing ", "elit. "};
+
+    char *text = SDL_malloc(size + 1);
+    size_t length = 0;
+    size_t since_tag = 0;
+    unsigned int seed = 42;
+
+    while (length < size)
+    {
+        seed = seed * 1103515245 + 12345;
+
+        const char *piece;
+
+        if (since_tag >= tag_spacing)
+        {
+            piece = tags[(seed >> 16) % SDL_arraysize(tags)];
+            since_tag = 0;
+        }
+        else if (with_newlines && (seed >> 16) % 16 == 0)
+        {
+            piece = "\n";
+        }
+        else
+        {
+            piece = words[(seed >> 16) % SDL_arraysize(words)];
+        }
+
+        size_t piece_length = SDL_strlen(piece);
+
+        if (length + piece_length > size)
+        {
+            break;
+        }
+
+        SDL_memcpy(text + length, piece, piece_length);
+        length += piece_length;
+        since_tag += piece_length;
+    }
+
+    text[length] = '\0';
+
+    return text;
+}
+
+typedef struct
+{
+    const char *text;
+    NapysRichTextOptions options;
+} ParseBenchData;
+
+static void ParseBench(void *userdata)
+{
+    ParseBenchData *data = (ParseBenchData *)userdata;
+
+    NapysCommandList *list = NapysParseRichText(data->text, &data->options);
+    NapysDestroyCommandList(list);
+}
+
+typedef struct
+{
+    const char *text;
+    size_t length;
+    const char *(*find)(const char *cursor, const char *end, char first, char second);
+} ScanBenchData;
+
+static void ScanBench(void *userdata)
+{
+    ScanBenchData *data = (ScanBenchData *)userdata;
+
+    const char *cursor = data->text;
+    const char *end = data->text + data->length;
+
+    while (cursor < end)
+    {
+        cursor = data->find(cursor, end, '{', '\n') + 1;
+    }
+}
+
+typedef struct
+{
+    NapysContext *ctx;
+    SDL_Renderer *renderer;
+    NapysRendererTTF *text_renderer;
+    NapysCommandList *list;
+    NapysCommandList *lists[8];
+    int frame;
+} RenderBenchData;
+
+static void ExecuteColdBench(void *userdata)
+{
+    RenderBenchData *data = (RenderBenchData *)userdata;
+
+    NapysRendererTTF *text_renderer = NapysCreateRendererTTF(data->ctx, data->renderer);
+    NapysExecuteCommandList(text_renderer, data->list);
+    NapysDestroyRendererTTF(text_renderer);
+}
+
+static void ExecuteWarmBench(void *userdata)
+{
+    RenderBenchData *data = (RenderBenchData *)userdata;
+
+    NapysExecuteCommandList(data->text_renderer, data->list);
+}
+
+static void ExecuteChangedBench(void *userdata)
+{
+    RenderBenchData *data = (RenderBenchData *)userdata;
+
+    // A score label updated every frame, the common case of dynamic text
+    char score[32];
+    SDL_snprintf(score, sizeof(score), "%d", data->frame++);
+
+    NapysClearCommandList(data->list);
+    NapysAddSetColorCommand(data->list, "yellow");
+    NapysAddDrawTextCommand(data->list, "Score: ");
+    NapysAddSetColorCommand(data->list, "white");
+    NapysAddDrawTextCommand(data->list, score);
+
+    NapysExecuteCommandList(data->text_renderer, data->list);
+}
+
+static void RenderFrameBench(void *userdata)
+{
+    RenderBenchData *data = (RenderBenchData *)userdata;
+
+    SDL_RenderClear(data->renderer);
+    NapysRenderTTF(data->text_renderer, 0, 0);
+    SDL_RenderPresent(data->renderer);
+}
+
+static void FontCacheChurnBench(void *userdata)
+{
+    RenderBenchData *data = (RenderBenchData *)userdata;
+
+    // Every execution asks for a size the small budget has most likely evicted
+    NapysExecuteCommandList(data->text_renderer, data->lists[data->frame++ % SDL_arraysize(data->lists)]);
+}
+
+static bool SetupRenderBench(RenderBenchData *data, SDL_Surface **surface, TTF_Font **font)
+{
+    *surface = SDL_CreateSurface(1280, 720, SDL_PIXELFORMAT_ARGB8888);
+    data->renderer = *surface ? SDL_CreateSoftwareRenderer(*surface) : NULL;
+    *font = TTF_OpenFont(NAPYS_BENCH_FONT_PATH, 24);
+    data->ctx = NapysCreateContext();
+
+    if (!data->renderer || !*font || !data->ctx)
+    {
+        return false;
+    }
+
+    SDL_Surface *icon = SDL_CreateSurface(24, 24, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Texture *icon_texture = icon ? SDL_CreateTextureFromSurface(data->renderer, icon) : NULL;
+    SDL_DestroySurface(icon);
+
+    NapysRegisterFont(data->ctx, *font, "main");
+    NapysRegisterString(data->ctx, "welcome", "Welcome to Napys!");
+    NapysRegisterCSSColors(data->ctx);
+    NapysRegisterSize(data->ctx, "small", 16);
+    NapysRegisterImage(data->ctx, "icon", icon_texture);
+
+    for (int i = 0; i < (int)SDL_arraysize(data->lists); i++)
+    {
+        char key[8];
+        SDL_snprintf(key, sizeof(key), "s%d", i);
+        NapysRegisterSize(data->ctx, key, 12.0f + 4.0f * i);
+    }
+
+    return true;
+}
+
+static void Usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [--json | --csv]\n", program);
+}
+
+int main(int argc, char *argv[])
+{
+    BenchFormat format = BENCH_FORMAT_TABLE;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--json") == 0)
+        {
+            format = BENCH_FORMAT_JSON;
+        }
+        else if (SDL_strcmp(argv[i], "--csv") == 0)
+        {
+            format = BENCH_FORMAT_CSV;
+        }
+        else
+        {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Must happen before anything is allocated through SDL
+    SDL_GetOriginalMemoryFunctions(&original_malloc, &original_calloc, &original_realloc, &original_free);
+    SDL_SetMemoryFunctions(CountingMalloc, CountingCalloc, CountingRealloc, CountingFree);
+
+    // The benchmark runs headless, rendering is done on a surface by the software renderer
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen,dummy");
+
+    if (!SDL_Init(SDL_INIT_VIDEO) || !TTF_Init())
+    {
+        fprintf(stderr, "Failed to initialize SDL: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    char *prose = GenerateRichText(BENCH_INPUT_SIZE, 512, false);
+    char *prose_newlines = GenerateRichText(BENCH_INPUT_SIZE, 512, true);
+    char *markup = GenerateRichText(BENCH_INPUT_SIZE, 16, false);
+    char *paragraph = GenerateRichText(2048, 64, true);
+    const char *label = "{{color:yellow}}Score: {{color:white}}1234";
+
+    if (format == BENCH_FORMAT_TABLE)
+    {
+        printf("Napys benchmark, input size: %d bytes\n\n", BENCH_INPUT_SIZE);
+    }
+
+    ScanBenchData scan_scalar = {prose, SDL_strlen(prose), NapysFindDelimiterScalar};
+    ScanBenchData scan_best = {prose, SDL_strlen(prose), NapysFindDelimiter};
+
+    RunBench("scan/scalar", ScanBench, &scan_scalar, scan_scalar.length);
+    RunBench("scan/vectorized", ScanBench, &scan_best, scan_best.length);
+
+    ParseBenchData parse_label = {label, {NULL, NULL, false}};
+    ParseBenchData parse_prose = {prose, {NULL, NULL, false}};
+    ParseBenchData parse_prose_newlines = {prose_newlines, {NULL, NULL, true}};
+    ParseBenchData parse_markup = {markup, {NULL, NULL, false}};
+
+    RunBench("parse/small", ParseBench, &parse_label, SDL_strlen(label));
+    RunBench("parse/prose", ParseBench, &parse_prose, SDL_strlen(prose));
+    RunBench("parse/prose+newlines", ParseBench, &parse_prose_newlines, SDL_strlen(prose_newlines));
+    RunBench("parse/dense-markup", ParseBench, &parse_markup, SDL_strlen(markup));
+
+    RenderBenchData render = {0};
+    SDL_Surface *surface = NULL;
+    TTF_Font *font = NULL;
+
+    if (SetupRenderBench(&render, &surface, &font))
+    {
+        NapysRichTextOptions options = {NULL, NULL, true};
+        render.list = NapysParseRichText(paragraph, &options);
+        NapysCompileCommandList(render.ctx, render.list);
+
+        render.text_renderer = NapysCreateRendererTTF(render.ctx, render.renderer);
+        NapysSetWrapWidth(render.text_renderer, 640);
+
+        RunBench("execute/cold", ExecuteColdBench, &render, 0);
+        RunBench("execute/warm", ExecuteWarmBench, &render, 0);
+
+        NapysExecuteCommandList(render.text_renderer, render.list);
+        RunBench("render/frame", RenderFrameBench, &render, 0);
+
+        NapysCommandList *label_list = NapysCreateCommandList();
+        NapysCommandList *paragraph_list = render.list;
+        render.list = label_list;
+        RunBench("execute/changed-label", ExecuteChangedBench, &render, 0);
+        render.list = paragraph_list;
+        NapysDestroyCommandList(label_list);
+
+        for (int i = 0; i < (int)SDL_arraysize(render.lists); i++)
+        {
+            char text[64];
+            SDL_snprintf(text, sizeof(text), "{{size:s%d}}Font cache churn", i);
+            render.lists[i] = NapysParseRichText(text, NULL);
+        }
+
+        NapysSetFontCacheBudget(render.ctx, 2, 0);
+        RunBench("font-cache/churn", FontCacheChurnBench, &render, 0);
+
+        for (int i = 0; i < (int)SDL_arraysize(render.lists); i++)
+        {
+            NapysDestroyCommandList(render.lists[i]);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Skipping render benchmarks: %s %s\n", SDL_GetError(), NapysGetError());
+    }
+
+    PrintResults(format);
+
+    NapysDestroyRendererTTF(render.text_renderer);
+    NapysDestroyCommandList(render.list);
+    NapysDestroyContext(render.ctx);
+    TTF_CloseFont(font);
+    SDL_DestroyRenderer(render.renderer);
+    SDL_DestroySurface(surface);
+
+    SDL_free(prose);
+    SDL_free(prose_newlines);
+    SDL_free(markup);
+    SDL_free(paragraph);
+
+    TTF_Quit();
+    SDL_Quit();
+
+    return 0;
+}
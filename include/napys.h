@@ -6,16 +6,26 @@
 #include <SDL3_ttf/SDL_ttf.h>
 
 /**
- * Maximum supported font size.
- * This is used to limit the number of font sizes cached, as they are stored in a plain array.
+ * Default maximum number of sizes kept resident per registered font, see NapysSetFontCacheBudget().
  */
+#define NAPYS_DEFAULT_FONT_CACHE_MAX_SIZES 32
 
-#define NAPYS_MAX_FONT_SIZE 256
+/**
+ * Default approximate memory budget in bytes per registered font, see NapysSetFontCacheBudget().
+ */
+#define NAPYS_DEFAULT_FONT_CACHE_MAX_BYTES (32 * 1024 * 1024)
+
+/**
+ * Initial number of fragment slots allocated by a NapysRendererTTF.
+ * The fragment storage grows on demand, so this only affects how early the first reallocation happens.
+ */
+#define NAPYS_TTF_RENDERER_INITIAL_FRAGMENTS 16
 
 /**
- * Maximum number of text fragments that can be rendered at once.
+ * Maximum number of unused TTF_Text objects kept by a NapysRendererTTF for reuse in later executions.
+ * Texts released beyond this limit, e.g. after a long label is replaced by a short one, are destroyed.
  */
-#define NAPYS_TTF_RENDERER_MAX_TEXTS 128
+#define NAPYS_TTF_RENDERER_MAX_FREE_TEXTS 64
 
 /**
  * Opaque handle for hashmap implementation.
@@ -23,12 +33,63 @@
 typedef struct NapysHashmap NapysHashmap;
 
 /**
- * Font cache, storing all available sizes for a given TTF font.
+ * Opaque handle for a bump allocator used to store command list strings.
+ */
+typedef struct NapysArena NapysArena;
+
+/**
+ * Opaque handle for the cache of parsed rich-text templates.
+ */
+typedef struct NapysTemplateCache NapysTemplateCache;
+
+/**
+ * Opaque handle for a pack of precompiled command lists loaded with NapysLoadCommandLists().
+ */
+typedef struct NapysCommandPack NapysCommandPack;
+
+/**
+ * Opaque handle for a glyph atlas, packing rasterized glyphs and images into shared textures.
+ */
+typedef struct NapysGlyphAtlas NapysGlyphAtlas;
+
+/**
+ * Limits for the number of font sizes kept resident by a font cache.
+ */
+typedef struct
+{
+    int max_sizes;    ///< Maximum number of sizes per font, 0 for no limit.
+    size_t max_bytes; ///< Maximum approximate memory used by the sizes of one font, 0 for no limit.
+} NapysFontCacheBudget;
+
+/**
+ * A single font size stored in a font cache.
  */
 typedef struct
 {
-    TTF_Font *sizes[NAPYS_MAX_FONT_SIZE];
+    TTF_Font *font;       ///< The font copy set to this size.
+    float ptsize;         ///< The point size of the font.
+    size_t approx_bytes;  ///< Approximate memory used by the font and its glyph cache.
+    Uint64 last_used;     ///< Font cache tick of the last query of this size, used for LRU eviction.
+    int refcount;         ///< Number of users that require the font to stay alive (e.g. text fragments using it).
+} NapysFontSize;
+
+/**
+ * Font cache, storing the sizes of a given TTF font that are currently in use.
+ *
+ * Sizes are created on demand with TTF_CopyFont() and the least recently used ones are closed
+ * when the cache goes over its budget, unless they are still used.
+ */
+typedef struct
+{
+    NapysFontSize *sizes;                ///< Sparse array of resident sizes.
+    int sizes_count;                     ///< The number of resident sizes.
+    int sizes_capacity;                  ///< The number of allocated size slots.
+    size_t approx_bytes;                 ///< Approximate memory used by all resident sizes.
+    Uint64 tick;                         ///< Counter incremented on every query, used for LRU eviction.
+    const NapysFontCacheBudget *budget;  ///< Budget of the owning context.
     TTF_Font *base;
+    SDL_Mutex *lock;                     ///< Guards the sizes and the use of the fonts, which are shared by all threads.
+    Uint64 copies;                       ///< Number of sizes created with TTF_CopyFont() since the last reset of the context statistics.
 } NapysFontCache;
 
 /**
@@ -52,12 +113,34 @@ typedef struct
 
     char *str;
     SDL_Color color;
-    int ptsize;
+    float ptsize;
     void *img;
+    float img_width;       ///< Width of the image, known at registration so layout does not need the image itself.
+    float img_height;      ///< Height of the image, known at registration so layout does not need the image itself.
+    Uint32 img_generation; ///< Context generation of the image registration, never repeated. Identifies the image contents in glyph atlases.
 } NapysRegistryEntry;
 
+/**
+ * Runtime statistics of a Napys context, accumulated since its creation or the last NapysResetContextStats().
+ */
+typedef struct
+{
+    Uint64 registry_lookups; ///< Number of registry and font lookups made while compiling command lists.
+    Uint64 registry_misses;  ///< Number of lookups that did not find a resource of the expected type.
+    Uint64 font_copies;      ///< Number of font sizes created with TTF_CopyFont() by the font caches.
+    Uint64 parse_ns;         ///< Time spent parsing in NapysParseRichTextCached() and NapysParseRichTextBatch(), in nanoseconds.
+    Uint64 layout_ns;        ///< Time spent laying out command lists, including the layouts of renderer executions, in nanoseconds.
+} NapysContextStats;
+
 /**
  * Napys context, containing the registry and font caches.
+ *
+ * Thread safety: parsing, layout (NapysLayoutCommandList()) and template cache lookups may run concurrently
+ * on any number of threads, also with command list execution on the render thread.
+ * Error messages are kept per thread. Registering resources, changing the font cache budget or template cache capacity
+ * and destroying the context must not run concurrently with any other use of the context.
+ * Renderers and command lists are not thread-safe and each one must be used by a single thread at a time,
+ * except command lists shared by the template cache.
  */
 typedef struct
 {
@@ -65,6 +148,17 @@ typedef struct
     NapysHashmap *fonts;
 
     NapysFontCache *default_font_cache;
+    NapysFontCacheBudget font_budget; ///< Budget applied to the font cache of every registered font.
+
+    Uint32 generation; ///< Registry generation, changed every time a resource is registered. Used to detect stale compiled command lists.
+    Uint32 strings_generation; ///< Changed every time a registered string is released by registering another resource under its key.
+
+    NapysTemplateCache *template_cache; ///< Cache of parsed rich-text templates, NULL if disabled.
+
+    SDL_Mutex *lock; ///< Serializes compilation of command lists, which may be shared between threads.
+
+    SDL_SpinLock stats_lock; ///< Guards the statistics, which are updated by all threads using the context.
+    NapysContextStats stats; ///< Statistics, except font_copies which are counted by the font caches.
 } NapysContext;
 
 /**
@@ -72,11 +166,40 @@ typedef struct
  *
  * Note, this works as SDL_GetError() - the function may return a message even last operation was successful.
  * Always use the return value of the called function for determining success or failure first.
+ * The message is kept per thread, so it is the last error of a Napys function called on the current thread.
  *
  * @return A pointer to the last error message, or NULL if no error occurred.
  */
 const char *NapysGetError();
 
+/**
+ * Profiling hooks, called at the beginning and the end of the expensive phases of Napys.
+ *
+ * Zones are named with static strings (e.g. "NapysParseRichText") and identified by a label, which is the address
+ * of the object the work is done for (the rich text, the renderer or the font cache), so zones of different labels
+ * can be told apart in a frame timeline. Zones are properly nested on every thread.
+ */
+typedef struct
+{
+    void(SDLCALL *begin_zone)(void *userdata, const char *name, Uint64 label); ///< Called when a zone begins.
+    void(SDLCALL *end_zone)(void *userdata, const char *name, Uint64 label);   ///< Called when a zone ends.
+    void *userdata;                                                            ///< Passed to both callbacks.
+} NapysProfilingHooks;
+
+/**
+ * Set the profiling hooks, e.g. to show Napys zones in a Tracy or Perfetto timeline.
+ *
+ * The hooks are called from every thread running Napys functions, so they must be thread-safe.
+ * The hooks are global and must not be changed while any other Napys function runs.
+ *
+ * Profiling is available only if Napys was built with the NAPYS_PROFILING option, otherwise the zones
+ * compile to nothing and this function fails.
+ *
+ * @param hooks The hooks to call, copied by Napys, or NULL to remove them.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysSetProfilingHooks(const NapysProfilingHooks *hooks);
+
 /**
  * Create a new Napys context
  *
@@ -112,6 +235,8 @@ bool NapysRegisterFont(NapysContext *ctx, TTF_Font *font, const char *name);
  *
  * The string can be used in Napys commands using the assigned key.
  * The string is stored as a simple C string and is copied internally.
+ * Registering a new value under the same key releases the previous copy, so layouts using the key
+ * must be laid out (or executed) again before they are used.
  * If you are using rich-text parser, do not include colon (:) in the key name, as it is reserved for commands.
  *
  * @param ctx The Napys context to register the string in.
@@ -148,13 +273,14 @@ void NapysRegisterCSSColors(NapysContext *ctx);
  * Register a font size in the Napys context.
  *
  * The size is registered under the specified key and can be used in Napys commands.
+ * Fractional sizes are supported.
  *
  * @param ctx The Napys context to register the size in.
  * @param key The key to register the size under.
- * @param pt The point size to register.
+ * @param pt The point size to register, must be positive.
  * @return true on success, false on failure (use NapysGetError() to get the error message).
  */
-bool NapysRegisterSize(NapysContext *ctx, const char *key, int pt);
+bool NapysRegisterSize(NapysContext *ctx, const char *key, float pt);
 
 /**
  * Register an image in the Napys context.
@@ -171,6 +297,77 @@ bool NapysRegisterSize(NapysContext *ctx, const char *key, int pt);
  */
 bool NapysRegisterImage(NapysContext *ctx, const char *key, void *img);
 
+/**
+ * Register an image with an explicit size in the Napys context.
+ *
+ * Works as NapysRegisterImage(), but the size of the image used for layout is given instead of being
+ * queried from the texture. The image may be NULL, in which case it only reserves space in the layout -
+ * useful to measure text with inline images without an SDL_Renderer (see NapysLayoutCommandList()).
+ *
+ * @param ctx The Napys context to register the image in.
+ * @param key The key to register the image under.
+ * @param img The SDL_Texture to register, or NULL.
+ * @param width The width of the image in pixels.
+ * @param height The height of the image in pixels.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysRegisterImageWithSize(NapysContext *ctx, const char *key, void *img, float width, float height);
+
+/**
+ * Set the budget for the font caches of a Napys context.
+ *
+ * Every registered font keeps the sizes requested by commands resident, so they can be reused.
+ * When a font goes over its budget, the least recently used sizes are closed, except the ones still used
+ * by executed renderers and the registered base font itself, so the budget may be temporarily exceeded.
+ * The memory budget is based on a rough estimate of the FreeType face and glyph cache size.
+ *
+ * By default, the budget is NAPYS_DEFAULT_FONT_CACHE_MAX_SIZES sizes and NAPYS_DEFAULT_FONT_CACHE_MAX_BYTES bytes per font.
+ *
+ * @param ctx The Napys context to configure.
+ * @param max_sizes Maximum number of sizes per font, 0 for no limit.
+ * @param max_bytes Maximum approximate memory in bytes per font, 0 for no limit.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysSetFontCacheBudget(NapysContext *ctx, int max_sizes, size_t max_bytes);
+
+/**
+ * Statistics of the font caches of a context.
+ */
+typedef struct
+{
+    int resident_sizes;  ///< Number of font sizes currently open, including the registered base fonts.
+    size_t approx_bytes; ///< Approximate memory used by all resident sizes.
+} NapysFontCacheStats;
+
+/**
+ * Get statistics of the font caches of a Napys context, summed over all registered fonts.
+ *
+ * @param ctx The Napys context to get the statistics from.
+ * @param stats The structure to store the statistics in.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysGetFontCacheStats(NapysContext *ctx, NapysFontCacheStats *stats);
+
+/**
+ * Get the runtime statistics of a Napys context.
+ *
+ * The counters accumulate until NapysResetContextStats() is called, so they can be sampled per frame
+ * by reading and resetting them once every frame.
+ *
+ * @param ctx The Napys context to get the statistics from.
+ * @param stats The structure to store the statistics in.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysGetContextStats(NapysContext *ctx, NapysContextStats *stats);
+
+/**
+ * Reset the runtime statistics of a Napys context to zero.
+ *
+ * @param ctx The Napys context to reset the statistics of.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysResetContextStats(NapysContext *ctx);
+
 /**
  * Destroy a Napys context.
  *
@@ -196,8 +393,20 @@ typedef enum
     NAPYS_COMMAND_TYPE_SET_FONT,
     NAPYS_COMMAND_TYPE_SET_SIZE,
     NAPYS_COMMAND_TYPE_NEWLINE,
+    NAPYS_COMMAND_TYPE_SET_ALIGN,
 } NapysCommandType;
 
+/**
+ * Horizontal alignment of the lines of a text.
+ */
+typedef enum
+{
+    NAPYS_ALIGN_LEFT,
+    NAPYS_ALIGN_CENTER,
+    NAPYS_ALIGN_RIGHT,
+    NAPYS_ALIGN_JUSTIFY ///< Lines broken by wrapping are stretched to the full width, other lines are aligned left.
+} NapysAlign;
+
 /**
  * Command structure for Napys.
  */
@@ -205,6 +414,7 @@ typedef struct
 {
     NapysCommandType type;
     char *data;
+    void *resolved; ///< Registry entry or font cache resolved from data by NapysCompileCommandList(), NULL if not resolved.
 } NapysCommand;
 
 /**
@@ -218,6 +428,18 @@ typedef struct
     NapysCommand *cmds;
     int cmd_count;
     int cmd_capacity;
+
+    NapysArena *strings; ///< String pool holding the data of all commands in the list.
+
+    SDL_AtomicInt refcount; ///< Number of owners of the list, it is freed by NapysDestroyCommandList() when the last one releases it.
+    bool immutable;         ///< If true, commands cannot be added to or removed from the list (e.g. lists shared by the template cache).
+
+    const NapysContext *compiled_ctx; ///< The context the commands were last compiled against, NULL if not compiled.
+    Uint32 compiled_generation;       ///< The context generation at the time of the last compilation.
+
+    Uint32 revision; ///< Changed when the list is created or cleared, never repeated. Together with cmd_count identifies the list contents.
+
+    const NapysCommandPack *pack; ///< The pack owning the list, NULL for lists owned by their users.
 } NapysCommandList;
 
 /**
@@ -225,6 +447,8 @@ typedef struct
  *
  * Command lists are used to store sequences of commands that can be executed by the renderer.
  * The command list is initially empty and can be filled with commands using the provided functions.
+ * Strings of all commands are stored in a single pool owned by the list, which is reused after clearing,
+ * so refilling a cleared list does not allocate memory unless it grows past its previous size.
  *
  * @return A pointer to the newly created command list, or NULL if an error occurred.
  */
@@ -233,8 +457,9 @@ NapysCommandList *NapysCreateCommandList();
 /**
  * Clear the command list, removing all commands.
  *
- * This function will free the memory used by the commands in the list, but not the list itself.
- * After this call, the command list will be empty.
+ * This function does not free any memory: the command array and the string pool are kept to be reused
+ * by the commands added later. After this call, the command list will be empty.
+ * Immutable lists (e.g. lists of the template cache or a command pack) are left unchanged and an error is set.
  *
  * @param list The command list to clear.
  */
@@ -245,6 +470,8 @@ void NapysClearCommandList(NapysCommandList *list);
  *
  * This will free all resources associated with the command list, including the commands themselves.
  * After this call, the command list pointer will be invalid.
+ * For shared lists (e.g. returned by NapysParseRichTextCached()), this releases the caller's reference
+ * and the list is freed only once no other owner uses it.
  *
  * @param list The command list to destroy.
  */
@@ -257,7 +484,7 @@ void NapysDestroyCommandList(NapysCommandList *list);
  * If the command list is full, it will be resized to accommodate the new command.
  *
  * @param list The command list to add the command to.
- * @param cmd The command to add (copied on addition).
+ * @param cmd The command to add (copied on addition, including the data string, which is copied into the list string pool).
  * @return true on success, false on failure (use NapysGetError() to get the error message).
  */
 bool NapysAddCommand(NapysCommandList *list, NapysCommand cmd);
@@ -329,7 +556,7 @@ bool NapysAddNewlineCommand(NapysCommandList *list);
  *
  * This function will add a command to draw an image at the current drawing position.
  * The image must be registered in the context registry before command list is executed.
- * The image will be drawn inline, centred vertically with the current font size.
+ * The image will be drawn inline, standing on the baseline of the line.
  * Executing a command with an unregistered image will have no effect.
  *
  * @param list The command list to add the command to.
@@ -352,14 +579,290 @@ bool NapysAddDrawImageCommand(NapysCommandList *list, const char *image_name);
  */
 bool NapysAddUseStringCommand(NapysCommandList *list, const char *key);
 
+/**
+ * Add a set align command to the command list.
+ *
+ * This function will add a command to set the horizontal alignment of the lines starting after it.
+ * Valid alignment names are "left", "center", "right" and "justify".
+ * Executing a command with an unknown alignment name will have no effect.
+ *
+ * @param list The command list to add the command to.
+ * @param align_name The name of the alignment to set.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysAddSetAlignCommand(NapysCommandList *list, const char *align_name);
+
+/**
+ * Compile a command list against a Napys context.
+ *
+ * This function resolves all resource names used by the commands (colors, sizes, fonts, images and strings)
+ * into direct references to the context registry, so executing the list does not need to look them up again.
+ * Names that are not registered are resolved to nothing and the corresponding commands will have no effect.
+ *
+ * Calling this function is optional - NapysExecuteCommandList() compiles the list automatically
+ * if it was never compiled, was compiled against another context or the context registry has changed since
+ * the last compilation. Adding commands to the list or clearing it discards the compilation result.
+ *
+ * @param ctx The Napys context to resolve resources from.
+ * @param list The command list to compile.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysCompileCommandList(NapysContext *ctx, NapysCommandList *list);
+
+/**
+ * Type of a layout run.
+ */
+typedef enum
+{
+    NAPYS_LAYOUT_RUN_TEXT,
+    NAPYS_LAYOUT_RUN_IMAGE
+} NapysLayoutRunType;
+
+/**
+ * Flags of a layout piece.
+ */
+typedef enum
+{
+    NAPYS_LAYOUT_PIECE_BREAK_AFTER = 1 << 0, ///< A line may be broken after the piece (it ends with whitespace).
+    NAPYS_LAYOUT_PIECE_NEWLINE = 1 << 1      ///< The piece is an explicit line break, without any text.
+} NapysLayoutPieceFlags;
+
+/**
+ * A measured, unbreakable piece of a layout - a word in one font and color with its trailing whitespace, or an image.
+ *
+ * Pieces are the cached result of measuring a command list, and lines are built from them,
+ * so a layout can be wrapped again at a different width without measuring any text.
+ */
+typedef struct
+{
+    NapysLayoutRunType type;
+    Uint32 flags; ///< Combination of NapysLayoutPieceFlags.
+
+    const char *text;      ///< Text of the piece, including the trailing whitespace.
+    size_t length;         ///< Length of the text in bytes.
+    void *img;             ///< Image of the piece.
+    Uint32 img_generation; ///< Registration of the image, see NapysRegistryEntry.
+
+    TTF_Font *font;             ///< The font of the text, kept alive in its font cache while used by the layout.
+    NapysFontCache *font_cache; ///< The font cache owning the font.
+    float ptsize;               ///< The font size in points.
+    SDL_Color color;            ///< The color of the text.
+
+    int width;   ///< Width of the piece without the trailing whitespace.
+    int advance; ///< Width of the piece including the trailing whitespace.
+    int height;  ///< Height of the piece.
+    int align;   ///< NapysAlign set by the last align command before the piece, -1 if none (the layout alignment applies).
+    int ascent;  ///< Height of the piece above the baseline, the font ascent for text, the whole height for images.
+    int descent; ///< Offset of the bottom of the piece from the baseline, as returned by TTF_GetFontDescent(), 0 for images.
+} NapysLayoutPiece;
+
+/**
+ * A single positioned piece of a layout - text on one line in one font and color, or an image.
+ */
+typedef struct
+{
+    NapysLayoutRunType type;
+
+    const char *text;      ///< Text of the run, not NUL-terminated. Points into the command list or context registry.
+    size_t length;         ///< Length of the text in bytes.
+    void *img;             ///< Image of the run, may be NULL for images registered only with a size.
+    Uint32 img_generation; ///< Registration of the image, see NapysRegistryEntry.
+
+    TTF_Font *font;             ///< The font to draw the text with, kept alive in its font cache while used by the layout.
+    NapysFontCache *font_cache; ///< The font cache owning the font.
+    float ptsize;               ///< The font size in points.
+    SDL_Color color;            ///< The color to draw the text with.
+
+    int x; ///< X position of the run, relative to the layout origin.
+    int y; ///< Y position of the run, relative to the layout origin.
+    int w; ///< Width of the run.
+    int h; ///< Height of the run.
+} NapysLayoutRun;
+
+/**
+ * A line of a layout.
+ */
+typedef struct
+{
+    int first_run;  ///< Index of the first run on the line.
+    int runs_count; ///< The number of runs on the line, 0 for empty lines.
+
+    int x; ///< X position of the line content after alignment, relative to the layout origin.
+    int y; ///< Y position of the top of the line, relative to the layout origin.
+    int w; ///< Width of the line content, without trailing whitespace.
+    int h; ///< Height of the line, from its highest ascent to its lowest descent.
+
+    NapysAlign align; ///< Alignment of the line.
+    bool wrapped;     ///< Whether the line was broken by wrapping rather than by an explicit new line.
+} NapysLayoutLine;
+
+/**
+ * Napys layout.
+ *
+ * Result of laying out a command list - a flat array of positioned runs, measured using only font metrics.
+ * Layout does not need an SDL_Renderer, so it can be used to measure text headlessly, and it is the common
+ * first stage of all Napys renderers.
+ *
+ * Please do not modify this structure directly, use the provided functions to create and manage the layout.
+ */
+typedef struct
+{
+    NapysContext *ctx; ///< The Napys context to resolve resources from.
+
+    NapysLayoutRun *runs; ///< Growable array of the laid out runs.
+    int runs_count;       ///< The number of runs.
+    int runs_capacity;    ///< The number of allocated runs.
+
+    NapysLayoutPiece *pieces; ///< Growable array of the measured pieces of the laid out command list.
+    int pieces_count;         ///< The number of pieces.
+    int pieces_capacity;      ///< The number of allocated pieces.
+
+    const NapysCommandList *pieces_list; ///< The command list the pieces were measured from, NULL if none.
+    Uint32 pieces_revision;              ///< The revision of the list at the time of measuring.
+    int pieces_cmd_count;                ///< The number of commands in the list at the time of measuring.
+    Uint32 pieces_generation;            ///< The context generation at the time of measuring.
+
+    NapysHashmap *word_sizes; ///< Sizes of the words measured before, keyed by font, size and text. NULL until used.
+
+    NapysLayoutLine *lines; ///< Growable array of the lines, in order from top to bottom.
+    int lines_count;        ///< The number of lines.
+    int lines_capacity;     ///< The number of allocated lines.
+
+    int wrap_width;   ///< Maximum width of a line, 0 to break lines only at explicit new lines.
+    NapysAlign align; ///< Alignment of lines before any align command.
+
+    SDL_Color current_color;            ///< The current text color.
+    TTF_Font *current_font;             ///< The current font used for measuring text.
+    NapysFontCache *current_font_cache; ///< The current font cache, must be the same as used by the current_font.
+    float current_font_size;            ///< The current font size in points.
+    int current_align;                  ///< The alignment set by the last align command, -1 if none.
+
+    SDL_Rect bounds; ///< The bounds of all the runs.
+} NapysLayout;
+
+/**
+ * Create a new Napys layout.
+ *
+ * @param ctx The Napys context to resolve resources from.
+ * @return A pointer to the newly created NapysLayout, or NULL if an error occurred.
+ */
+NapysLayout *NapysCreateLayout(NapysContext *ctx);
+
+/**
+ * Destroy a Napys layout.
+ *
+ * @param layout The NapysLayout to destroy.
+ */
+void NapysDestroyLayout(NapysLayout *layout);
+
+/**
+ * Set the wrap width of a Napys layout.
+ *
+ * Lines longer than the wrap width are broken at whitespace, across font, size and color changes.
+ * Words that do not fit on a line on their own are broken between characters.
+ * The new width is applied by the next NapysLayoutCommandList() call, which reuses the measurements
+ * of the previous call if the command list did not change, so re-wrapping costs only the line breaking.
+ *
+ * @param layout The NapysLayout to configure.
+ * @param wrap_width Maximum width of a line in pixels, 0 to break lines only at explicit new lines.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysSetLayoutWrapWidth(NapysLayout *layout, int wrap_width);
+
+/**
+ * Set the alignment of a Napys layout.
+ *
+ * Lines are aligned within the wrap width, or within the widest line if the layout is not wrapped.
+ * Align commands in the command list override this alignment for the lines after them.
+ * Alignment is applied by the next NapysLayoutCommandList() call as a shift of the runs of each line, once
+ * the width of the line is known, so it needs neither measuring the text again nor a second layout pass.
+ *
+ * @param layout The NapysLayout to configure.
+ * @param align The alignment to use.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysSetLayoutAlign(NapysLayout *layout, NapysAlign align);
+
+/**
+ * Lay out a command list.
+ *
+ * Replaces the runs of the layout with the runs of the command list. Text is split into words, which are measured
+ * with TTF_GetStringSize() and then broken into lines (see NapysSetLayoutWrapWidth()). Consecutive words in the same
+ * font and color on the same line form a single run. Images are measured using the size known at their registration.
+ * All runs of a line share a common baseline: a line is as tall as its highest ascent and lowest descent
+ * (TTF_GetFontAscent() and TTF_GetFontDescent()), and images stand on the baseline.
+ * Measurements are kept until the list or the context registry changes, so laying out the same list again is cheap.
+ * After a change, only words the layout has not measured before in the same font and size are measured again,
+ * so refilling a list or registering a string, e.g. a ticking counter, costs only the changed words.
+ *
+ * Text of the runs points into the command list and the context registry, so the layout is valid only until
+ * the command list is changed or destroyed, or the strings it uses are registered again.
+ *
+ * @param layout The NapysLayout to fill.
+ * @param list The command list to lay out.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysLayoutCommandList(NapysLayout *layout, NapysCommandList *list);
+
+/**
+ * Get the bounds of a layout.
+ *
+ * @param layout The NapysLayout to get the bounds from.
+ * @param output The SDL_Rect to store the bounds in. If NULL, the bounds will not be returned.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysGetLayoutBounds(NapysLayout *layout, SDL_Rect *output);
+
+/**
+ * A single text or image fragment of NapysRendererTTF output.
+ *
+ * Fragments are kept between executions, so re-executing a similar command list
+ * updates the existing TTF_Text objects in place instead of creating new ones.
+ */
 typedef struct
 {
     TTF_Text *text;
     SDL_Texture *img;
     int x;
     int y;
+    int w;                      ///< Width of the fragment, as measured by the layout.
+    int h;                      ///< Height of the fragment, as measured by the layout.
+    TTF_Font *font;             ///< The font the text fragment was created or last updated with, kept alive in its font cache while used.
+    NapysFontCache *font_cache; ///< The font cache owning the font.
+    SDL_Color color;            ///< The color the text fragment was created or last updated with.
+
+    bool pending; ///< Whether the text is not yet created or updated for the last execution (see NapysSetLazyTexts()).
+    int run;      ///< Index of the executed layout run of a pending text fragment.
+
+    int first_glyph;  ///< The number of glyphs in the fragments before this one, used for revealing.
+    int glyphs_count; ///< The number of glyphs (characters) of the fragment, 1 for images.
 } NapysFragmentTTF;
 
+/**
+ * A line of NapysRendererTTF output, used to find the fragments intersecting a clip rectangle.
+ */
+typedef struct
+{
+    int y;               ///< Y position of the top of the line.
+    int h;               ///< Height of the line.
+    int first_fragment;  ///< Index of the first fragment of the line.
+    int fragments_count; ///< The number of fragments of the line.
+} NapysLineTTF;
+
+/**
+ * Runtime statistics of a NapysRendererTTF, accumulated since its creation or the last NapysResetRendererStats().
+ */
+typedef struct
+{
+    Uint64 fragments_created;   ///< Number of TTF_Text objects created for text fragments.
+    Uint64 fragments_reused;    ///< Number of text fragments that reused a TTF_Text of a previous execution or of the pool.
+    Uint64 fragments_destroyed; ///< Number of TTF_Text objects destroyed, e.g. because the pool was full.
+    Uint64 draw_calls;          ///< Number of TTF_DrawRendererText() and SDL_RenderTexture() calls issued.
+    Uint64 bytes_allocated;     ///< Bytes (re)allocated for the fragment, line and pool storage of the renderer.
+    Uint64 execute_ns;          ///< Time spent executing command lists and layouts, in nanoseconds.
+    Uint64 render_ns;           ///< Time spent in NapysRenderTTF() and NapysRenderTTFClipped(), in nanoseconds.
+} NapysRendererStats;
+
 /**
  * Napys SDL TTF renderer.
  *
@@ -371,19 +874,38 @@ typedef struct
     TTF_TextEngine *engine;     ///< The TTF_TextEngine used for rendering text.
     SDL_Renderer *sdl_renderer; ///< The SDL_Renderer used for rendering images and text.
 
-    NapysFragmentTTF fragments[NAPYS_TTF_RENDERER_MAX_TEXTS]; ///< Array of text or image fragments to render.
-    int fragments_count;                                      ///< The number of fragments currently in the array.
-    int fragment_pointer;                                     ///< The current pointer in the fragments array, used to add new fragments.
+    NapysFragmentTTF *fragments; ///< Growable array of text or image fragments to render.
+    int fragments_count;         ///< The number of fragments currently in the array, including ones kept from the previous execution.
+    int fragments_capacity;      ///< The number of allocated fragment slots.
+    int fragment_pointer;        ///< The current pointer in the fragments array, used to reuse or add fragments during execution.
+
+    TTF_Text **free_texts;   ///< Pool of TTF_Text objects no longer used by any fragment, reused before creating new ones.
+    int free_texts_count;    ///< The number of TTF_Text objects in the pool.
+    int free_texts_capacity; ///< The number of allocated pool slots.
+
+    NapysLineTTF *lines; ///< Growable array of the lines of the fragments, sorted from top to bottom.
+    int lines_count;     ///< The number of lines.
+    int lines_capacity;  ///< The number of allocated lines.
 
-    SDL_Color current_color;            ///< The current drawing color, used for text and images.
-    TTF_Font *current_font;             ///< The current font used for rendering text.
-    NapysFontCache *current_font_cache; ///< The current font cache used for rendering text, must be the same as used by the current_font.
-    int current_font_size;              ///< The current font size in points, used for rendering text.
+    bool lazy_texts;                    ///< Whether texts are created or updated only when they are first rendered.
+    const NapysLayout *executed_layout; ///< The last executed layout, the source of pending text fragments.
+    Uint32 executed_strings_generation; ///< The context strings generation at the time of the last execution.
 
-    int draw_x; ///< The current x position for drawing text and images.
-    int draw_y; ///< The current y position for drawing text and images.
+    bool texture_cache;         ///< Whether the output is baked into cache_texture and drawn with a single blit.
+    SDL_Texture *cache_texture; ///< Render target with the baked output, NULL if not created yet.
+    bool cache_valid;           ///< Whether cache_texture holds the output of the last execution.
+    Uint32 cache_generation;    ///< The context generation at the time of baking.
 
-    SDL_Rect bounds; ///< The bounds of the rendered text, updated during command list execution.
+    int glyphs_count;      ///< The total number of glyphs of the executed output.
+    int revealed_glyphs;   ///< The number of glyphs to draw, -1 to draw all of them.
+    TTF_Text *reveal_text; ///< Text showing the revealed part of the partially revealed fragment, NULL if not created yet.
+    int reveal_fragment;   ///< Index of the fragment shown by reveal_text, -1 if none.
+    size_t reveal_length;  ///< Length of the text shown by reveal_text in bytes.
+
+    NapysLayout *layout; ///< Layout of the executed command list.
+    SDL_Rect bounds;     ///< The bounds of the executed layout.
+
+    NapysRendererStats stats; ///< Runtime statistics, see NapysGetRendererStats().
 } NapysRendererTTF;
 
 /**
@@ -411,6 +933,111 @@ NapysRendererTTF *NapysCreateRendererTTF(NapysContext *ctx, SDL_Renderer *render
  */
 void NapysDestroyRendererTTF(NapysRendererTTF *renderer);
 
+/**
+ * Set the wrap width of a Napys TTF renderer.
+ *
+ * Takes effect on the next NapysExecuteCommandList() call (see NapysSetLayoutWrapWidth()).
+ * Executing the same command list again after a width change, e.g. when the window is resized, only breaks
+ * the lines again: no text is measured again, and the existing TTF_Text objects are updated in place.
+ *
+ * @param renderer The NapysRendererTTF to configure.
+ * @param wrap_width Maximum width of a line in pixels, 0 to break lines only at explicit new lines.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysSetWrapWidth(NapysRendererTTF *renderer, int wrap_width);
+
+/**
+ * Set the alignment of a Napys TTF renderer.
+ *
+ * Takes effect on the next NapysExecuteCommandList() call (see NapysSetLayoutAlign()).
+ * Aligned texts reuse their TTF_Text objects, only their positions change.
+ *
+ * @param renderer The NapysRendererTTF to configure.
+ * @param align The alignment to use.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysSetAlign(NapysRendererTTF *renderer, NapysAlign align);
+
+/**
+ * Enable or disable lazy creation of texts in a Napys TTF renderer.
+ *
+ * By default, execution creates or updates the TTF_Text objects of all fragments. With lazy texts enabled,
+ * execution only records the fragments, and their TTF_Text objects are created or updated when they are
+ * first rendered, so a long document shown through NapysRenderTTFClipped() only pays for the lines in view.
+ *
+ * While lazy texts are enabled, the executed command list (or layout, for NapysExecuteLayout()) must stay valid
+ * and unchanged until the next execution, as the texts are read from it while rendering.
+ * Texts not created yet are skipped after a registered string is replaced in the context, until the next execution.
+ *
+ * @param renderer The NapysRendererTTF to configure.
+ * @param lazy_texts true to create texts only when they are first rendered.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysSetLazyTexts(NapysRendererTTF *renderer, bool lazy_texts);
+
+/**
+ * Enable or disable the texture cache of a Napys TTF renderer.
+ *
+ * With the texture cache enabled, NapysRenderTTF() bakes the executed output into a render target texture
+ * of the size of the output bounds once, and on later frames draws just that texture, instead of drawing
+ * every text and image fragment. This suits static labels, especially on software and low-end renderers.
+ * The texture is baked again after the next execution, or when the context registry changes.
+ * If the SDL_Renderer does not support render targets, the fragments are drawn as without the cache.
+ * NapysRenderTTFClipped() always draws the fragments.
+ *
+ * @param renderer The NapysRendererTTF to configure.
+ * @param texture_cache true to enable the texture cache, false to disable it and free the texture.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysSetTextureCache(NapysRendererTTF *renderer, bool texture_cache);
+
+/**
+ * Limit the number of glyphs drawn by a Napys TTF renderer, e.g. for a typewriter effect in dialogues.
+ *
+ * Only the first count glyphs (characters, including whitespace, with every image counting as one) of the executed
+ * output are drawn. The already laid out fragments are used as they are: fragments before the limit are drawn
+ * whole, fragments after it are skipped, and the revealed part of the fragment at the limit is drawn
+ * with a single extra TTF_Text, so advancing the reveal every frame needs no execution.
+ * For a time-based reveal, set the count from the elapsed time, e.g. (int)(elapsed_seconds * glyphs_per_second).
+ * The limit is kept across executions, and the texture cache is not used while the output is partially revealed.
+ *
+ * @param renderer The NapysRendererTTF to configure.
+ * @param count The number of glyphs to draw, or a negative number to draw all of them.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysSetRevealedGlyphs(NapysRendererTTF *renderer, int count);
+
+/**
+ * Get the total number of glyphs of the executed output of a Napys TTF renderer.
+ *
+ * The reveal is complete when the revealed glyph count reaches this number (see NapysSetRevealedGlyphs()).
+ *
+ * @param renderer The NapysRendererTTF to query.
+ * @param count Pointer to store the number of glyphs in.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysGetGlyphCount(NapysRendererTTF *renderer, int *count);
+
+/**
+ * Get the runtime statistics of a Napys TTF renderer.
+ *
+ * The counters accumulate until NapysResetRendererStats() is called, so they can be sampled per frame.
+ * Time spent laying out is also included in the layout_ns statistics of the context.
+ *
+ * @param renderer The Napys TTF renderer to get the statistics from.
+ * @param stats The structure to store the statistics in.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysGetRendererStats(NapysRendererTTF *renderer, NapysRendererStats *stats);
+
+/**
+ * Reset the runtime statistics of a Napys TTF renderer to zero.
+ *
+ * @param renderer The Napys TTF renderer to reset the statistics of.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysResetRendererStats(NapysRendererTTF *renderer);
+
 /**
  * Execute a command list with the Napys TTF renderer.
  *
@@ -418,6 +1045,10 @@ void NapysDestroyRendererTTF(NapysRendererTTF *renderer);
  * according to the commands internally. It will also update the current drawing position and bounds.
  * Executing a command list will reset the renderer state, so all your commands should be in the same list,
  * if you want to render multiple texts or images in one go.
+ * Fragments produced by the previous execution are reused in order: a text fragment whose contents, font or color
+ * are unchanged is kept as is, otherwise only the changed properties are updated in place, so re-executing
+ * a list where only a few texts changed (e.g. a ticking counter) costs only those updates.
+ * The list is compiled against the renderer context first, unless it is already up to date (see NapysCompileCommandList()).
  * After command list is executed, the result can be rendered every frame using NapysRenderTTF().
  *
  * @param renderer The NapysRendererTTF to use for rendering.
@@ -425,6 +1056,19 @@ void NapysDestroyRendererTTF(NapysRendererTTF *renderer);
  */
 void NapysExecuteCommandList(NapysRendererTTF *renderer, NapysCommandList *list);
 
+/**
+ * Execute an already computed layout with the Napys TTF renderer.
+ *
+ * Works as NapysExecuteCommandList(), but skips the layout stage, e.g. for labels laid out on worker threads
+ * with NapysParseRichTextBatch(). Only the TTF_Text objects are created or updated.
+ * The layout must have been made with the same context as the renderer, and the command list it was made from
+ * must still be valid.
+ *
+ * @param renderer The NapysRendererTTF to use for rendering.
+ * @param layout The layout to execute.
+ */
+void NapysExecuteLayout(NapysRendererTTF *renderer, const NapysLayout *layout);
+
 /**
  * Render the command list execution result.
  *
@@ -440,6 +1084,22 @@ void NapysExecuteCommandList(NapysRendererTTF *renderer, NapysCommandList *list)
  */
 void NapysRenderTTF(NapysRendererTTF *renderer, float x, float y);
 
+/**
+ * Render the part of the command list execution result that intersects a clip rectangle.
+ *
+ * Works as NapysRenderTTF(), but draws only the fragments that intersect the clip rectangle, e.g. the visible
+ * part of a scrolled chat log. The first visible line is found with a binary search over the lines of the output,
+ * so the cost depends on the number of visible fragments, not on the length of the whole text.
+ * The clip rectangle only selects the fragments to draw, fragments crossing its edges are drawn whole;
+ * use SDL_SetRenderClipRect() to cut them.
+ *
+ * @param renderer The NapysRendererTTF to use for rendering.
+ * @param x The x position to render the text at.
+ * @param y The y position to render the text at.
+ * @param clip The visible area, in the same coordinates as x and y.
+ */
+void NapysRenderTTFClipped(NapysRendererTTF *renderer, float x, float y, const SDL_Rect *clip);
+
 /**
  * Get the bounds of the rendered text.
  *
@@ -452,6 +1112,226 @@ void NapysRenderTTF(NapysRendererTTF *renderer, float x, float y);
  */
 bool NapysGetRenderedTextBounds(NapysRendererTTF *renderer, SDL_Rect *output);
 
+/**
+ * Size in pixels of a single (square) glyph atlas page texture.
+ */
+#define NAPYS_GLYPH_ATLAS_PAGE_SIZE 1024
+
+/**
+ * Create a new glyph atlas.
+ *
+ * A glyph atlas can be shared by many atlas renderers (see NapysCreateSharedRendererAtlas()),
+ * so glyphs used by several labels are rasterized and stored only once, and the labels can be drawn together
+ * with NapysRenderAtlasBatch().
+ *
+ * Atlas pages are render target textures, so the SDL_Renderer must support render targets
+ * (all built-in renderers, including the software one, do).
+ *
+ * Images are copied into the atlas when first drawn after their registration, so register an image again
+ * after changing its texture contents. Glyphs and images are never evicted on their own, use
+ * NapysGetGlyphAtlasPageCount() and NapysClearGlyphAtlas() to bound the memory used by the atlas.
+ *
+ * @param renderer The SDL_Renderer to create the atlas textures with.
+ * @return A pointer to the newly created NapysGlyphAtlas, or NULL if an error occurred.
+ */
+NapysGlyphAtlas *NapysCreateGlyphAtlas(SDL_Renderer *renderer);
+
+/**
+ * Destroy a glyph atlas.
+ *
+ * All atlas renderers sharing the atlas must be destroyed before.
+ *
+ * @param atlas The NapysGlyphAtlas to destroy.
+ */
+void NapysDestroyGlyphAtlas(NapysGlyphAtlas *atlas);
+
+/**
+ * Remove all glyphs and images from a glyph atlas and release its pages.
+ *
+ * Labels executed before clearing refer to the removed glyphs, so they are not drawn
+ * until they are executed again by their atlas renderers.
+ *
+ * @param atlas The NapysGlyphAtlas to clear.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysClearGlyphAtlas(NapysGlyphAtlas *atlas);
+
+/**
+ * Get the number of page textures of a glyph atlas.
+ *
+ * @param atlas The NapysGlyphAtlas to query.
+ * @return The number of pages, 0 if the atlas is NULL or empty.
+ */
+int NapysGetGlyphAtlasPageCount(NapysGlyphAtlas *atlas);
+
+/**
+ * A contiguous range of atlas renderer vertices, all textured by the same atlas page.
+ */
+typedef struct
+{
+    int page;         ///< Index of the atlas page texture.
+    int first_vertex; ///< Index of the first vertex of the range.
+    int quad_count;   ///< Number of quads (4 vertices, 6 indices each) in the range.
+} NapysAtlasDrawRange;
+
+/**
+ * Napys SDL atlas renderer.
+ *
+ * An alternative to NapysRendererTTF, which rasterizes every glyph and inline image once into a glyph atlas
+ * and draws the whole label with a single SDL_RenderGeometry() call per atlas page (usually just one),
+ * instead of one draw call per text fragment and image.
+ *
+ * Please do not use this structure directly, use the provided functions to create and manage the renderer.
+ */
+typedef struct
+{
+    NapysContext *ctx;          ///< The Napys context to use for rendering.
+    SDL_Renderer *sdl_renderer; ///< The SDL_Renderer used for drawing.
+    NapysGlyphAtlas *atlas;     ///< The glyph atlas storing rasterized glyphs and images.
+    bool owns_atlas;            ///< Whether the atlas was created by (and is destroyed with) this renderer.
+
+    SDL_Vertex *vertices;      ///< Vertices of the executed label, relative to its origin and grouped by atlas page.
+    SDL_Vertex *draw_vertices; ///< Vertices translated to the last drawing position.
+    int vertices_count;        ///< The number of vertices in the arrays.
+    int vertices_capacity;     ///< The number of allocated vertices.
+    int *indices;              ///< Shared index pattern for quads, large enough for the biggest draw range.
+    int indices_capacity;      ///< The number of allocated indices.
+    float draw_x_offset;       ///< X position the draw_vertices are currently translated to.
+    float draw_y_offset;       ///< Y position the draw_vertices are currently translated to.
+
+    NapysAtlasDrawRange *ranges; ///< Per atlas page vertex ranges, one SDL_RenderGeometry() call each.
+    int ranges_count;            ///< The number of draw ranges.
+    int ranges_capacity;         ///< The number of allocated draw ranges.
+    int *quad_pages;             ///< Atlas page of every quad, used to group the vertices by page.
+
+    NapysLayout *layout; ///< Layout of the executed command list.
+    SDL_Rect bounds;     ///< The bounds of the executed layout.
+    Uint32 atlas_epoch;  ///< Number of clears of the atlas at the time of the execution, labels executed before a clear are not drawn.
+} NapysRendererAtlas;
+
+/**
+ * Create a new Napys atlas renderer.
+ *
+ * The renderer creates its own glyph atlas. Atlas pages are render target textures,
+ * so the SDL_Renderer must support render targets (all built-in renderers, including the software one, do).
+ *
+ * @param ctx The Napys context to use for rendering.
+ * @param renderer The SDL_Renderer to use for rendering.
+ * @return A pointer to the newly created NapysRendererAtlas, or NULL if an error occurred.
+ */
+NapysRendererAtlas *NapysCreateRendererAtlas(NapysContext *ctx, SDL_Renderer *renderer);
+
+/**
+ * Create a new Napys atlas renderer using an existing glyph atlas.
+ *
+ * Use this to create one renderer per label, all sharing the same atlas,
+ * and then draw them together with NapysRenderAtlasBatch().
+ * The atlas is not destroyed with the renderer.
+ *
+ * @param ctx The Napys context to use for rendering.
+ * @param atlas The glyph atlas to use, created with NapysCreateGlyphAtlas().
+ * @return A pointer to the newly created NapysRendererAtlas, or NULL if an error occurred.
+ */
+NapysRendererAtlas *NapysCreateSharedRendererAtlas(NapysContext *ctx, NapysGlyphAtlas *atlas);
+
+/**
+ * Destroy a Napys atlas renderer, including its glyph atlas.
+ *
+ * None of the registered resources in the context will be freed.
+ *
+ * @param renderer The NapysRendererAtlas to destroy.
+ */
+void NapysDestroyRendererAtlas(NapysRendererAtlas *renderer);
+
+/**
+ * Set the wrap width of a Napys atlas renderer.
+ *
+ * Works as NapysSetWrapWidth(), taking effect on the next NapysExecuteCommandListAtlas() call.
+ *
+ * @param renderer The NapysRendererAtlas to configure.
+ * @param wrap_width Maximum width of a line in pixels, 0 to break lines only at explicit new lines.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysSetAtlasWrapWidth(NapysRendererAtlas *renderer, int wrap_width);
+
+/**
+ * Set the alignment of a Napys atlas renderer.
+ *
+ * Works as NapysSetAlign(), taking effect on the next NapysExecuteCommandListAtlas() call.
+ *
+ * @param renderer The NapysRendererAtlas to configure.
+ * @param align The alignment to use.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysSetAtlasAlign(NapysRendererAtlas *renderer, NapysAlign align);
+
+/**
+ * Placement of a label drawn by NapysRenderAtlasBatch().
+ */
+typedef struct
+{
+    NapysRendererAtlas *label; ///< The atlas renderer with the executed command list of the label.
+    float x;                   ///< The x position to render the label at.
+    float y;                   ///< The y position to render the label at.
+} NapysAtlasPlacement;
+
+/**
+ * Execute a command list with the Napys atlas renderer.
+ *
+ * Works as NapysExecuteCommandList(), but instead of creating TTF_Text objects, it lays out the glyphs of the texts
+ * one by one, adding the ones not yet rasterized to the atlas, and builds the vertices of the whole label.
+ * Inline images are copied into the atlas as well, so they are drawn in the same batch as the text.
+ *
+ * @param renderer The NapysRendererAtlas to use for rendering.
+ * @param list The command list to execute.
+ */
+void NapysExecuteCommandListAtlas(NapysRendererAtlas *renderer, NapysCommandList *list);
+
+/**
+ * Execute an already computed layout with the Napys atlas renderer.
+ *
+ * Works as NapysExecuteCommandListAtlas(), but skips the layout stage (see NapysExecuteLayout()).
+ *
+ * @param renderer The NapysRendererAtlas to use for rendering.
+ * @param layout The layout to execute.
+ */
+void NapysExecuteLayoutAtlas(NapysRendererAtlas *renderer, const NapysLayout *layout);
+
+/**
+ * Render the command list execution result of the atlas renderer.
+ *
+ * Draws the whole label with one SDL_RenderGeometry() call per atlas page used by it.
+ *
+ * @param renderer The NapysRendererAtlas to use for rendering.
+ * @param x The x position to render the text at.
+ * @param y The y position to render the text at.
+ */
+void NapysRenderAtlas(NapysRendererAtlas *renderer, float x, float y);
+
+/**
+ * Get the bounds of the text rendered by the atlas renderer.
+ *
+ * @param renderer The NapysRendererAtlas to get the bounds from.
+ * @param output The SDL_Rect to store the bounds in. If NULL, the bounds will not be returned.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysGetAtlasRenderedTextBounds(NapysRendererAtlas *renderer, SDL_Rect *output);
+
+/**
+ * Render many labels sharing the same glyph atlas at once.
+ *
+ * Geometry of all the labels is merged per atlas page, so the whole batch is drawn
+ * with one SDL_RenderGeometry() call per atlas page (usually just one), regardless of the number of labels.
+ * Pages are drawn one after another, and only the quads within a page keep the order of the placements,
+ * so overlapping labels are layered in placement order only if all their glyphs are on the same page.
+ *
+ * @param atlas The glyph atlas shared by all the labels.
+ * @param placements The labels to draw and their positions.
+ * @param count The number of placements.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysRenderAtlasBatch(NapysGlyphAtlas *atlas, const NapysAtlasPlacement *placements, int count);
+
 /**
  * Options for parsing rich text.
  */
@@ -482,6 +1362,9 @@ typedef struct
  *
  * The requested resources shall be registered in the Napys context before executing the command list.
  *
+ * The text is copied once into the string pool of the created list and parsed in place,
+ * so the parser makes no allocations per text segment or tag, and the text can be freed right after this call.
+ *
  * @param text The rich text string to parse.
  * @param options Optional options for parsing rich text, can be NULL to use defaults.
  *
@@ -489,4 +1372,174 @@ typedef struct
  */
 NapysCommandList *NapysParseRichText(const char *text, const NapysRichTextOptions *options);
 
+/**
+ * Statistics of the context template cache.
+ */
+typedef struct
+{
+    Uint64 hits;   ///< Number of lookups that returned an already parsed list.
+    Uint64 misses; ///< Number of lookups that had to parse the text.
+    int entries;   ///< Number of templates currently cached.
+    int capacity;  ///< Maximum number of cached templates.
+} NapysTemplateCacheStats;
+
+/**
+ * Enable, resize or disable the template cache of a Napys context.
+ *
+ * The template cache remembers command lists produced by NapysParseRichTextCached(), keyed by the source text
+ * and parsing options, so parsing the same markup again returns the cached list instead of re-tokenising it.
+ * When the cache is full, the least recently used template is evicted.
+ * The cache is disabled by default.
+ *
+ * @param ctx The Napys context to configure.
+ * @param capacity Maximum number of cached templates, 0 to disable the cache and release all cached lists.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysSetTemplateCacheCapacity(NapysContext *ctx, int capacity);
+
+/**
+ * Parse rich text using the template cache of the context.
+ *
+ * Works as NapysParseRichText(), but if the same text was already parsed with equal options, the cached list is returned.
+ * The returned list is shared and immutable: commands cannot be added or cleared, but it can be executed by any renderer
+ * of this context. Release it with NapysDestroyCommandList() when you no longer need it - it will stay valid
+ * even if the cache evicts it in the meantime.
+ *
+ * If the template cache is disabled, this simply parses the text into a new list.
+ *
+ * @param ctx The Napys context owning the template cache.
+ * @param text The rich text string to parse.
+ * @param options Optional options for parsing rich text, can be NULL to use defaults.
+ * @return A pointer to the command list, or NULL if an error occurred (use NapysGetError() to get the error message).
+ */
+NapysCommandList *NapysParseRichTextCached(NapysContext *ctx, const char *text, const NapysRichTextOptions *options);
+
+/**
+ * Get statistics of the context template cache.
+ *
+ * @param ctx The Napys context to get the statistics from.
+ * @param stats The structure to store the statistics in.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysGetTemplateCacheStats(NapysContext *ctx, NapysTemplateCacheStats *stats);
+
+/**
+ * Result of parsing and laying out a single text of a batch.
+ */
+typedef struct
+{
+    NapysCommandList *list; ///< The parsed command list, NULL if parsing failed.
+    NapysLayout *layout;    ///< The layout of the list, NULL if parsing or layout failed.
+    SDL_Rect bounds;        ///< The measured bounds of the text.
+} NapysBatchItem;
+
+/**
+ * Parse and lay out many rich text strings in parallel.
+ *
+ * The texts are split between the calling thread and thread_count - 1 worker threads. Each thread works through
+ * its own share of the texts and steals from the others when it runs out, so an uneven mix of long and short
+ * texts keeps all threads busy until the end.
+ *
+ * The resulting layouts can be executed on the render thread with NapysExecuteLayout() or NapysExecuteLayoutAtlas(),
+ * which only creates the TTF_Text objects or atlas geometry. Release the results with NapysDestroyBatchItems().
+ *
+ * See NapysContext for the operations that must not run concurrently with this function.
+ *
+ * @param ctx The Napys context to resolve resources from.
+ * @param texts The rich text strings to parse.
+ * @param count The number of texts.
+ * @param options Optional options for parsing rich text, can be NULL to use defaults.
+ * @param thread_count Number of threads to use including the calling one, 0 to use one per logical CPU core.
+ * @param items Array of count items to store the results in.
+ * @return true if all texts were parsed and laid out, false otherwise (use NapysGetError() to get the error message).
+ */
+bool NapysParseRichTextBatch(NapysContext *ctx, const char *const *texts, int count, const NapysRichTextOptions *options,
+                             int thread_count, NapysBatchItem *items);
+
+/**
+ * Destroy the command lists and layouts of batch items.
+ *
+ * @param items The items filled by NapysParseRichTextBatch().
+ * @param count The number of items.
+ */
+void NapysDestroyBatchItems(NapysBatchItem *items, int count);
+
+/**
+ * Version of the command pack format written by NapysSaveCommandLists().
+ */
+#define NAPYS_COMMAND_PACK_VERSION 1
+
+/**
+ * Save named command lists into a command pack.
+ *
+ * The pack is a relocatable blob without pointers: a header, a table of the lists sorted by name,
+ * the commands of all lists and a single table of all strings. It can be loaded with NapysLoadCommandLists()
+ * straight from memory, e.g. a memory-mapped file, so shipping precompiled packs replaces parsing markup at startup.
+ * Only the commands are stored, the lists are compiled against a context again when they are used.
+ * Lists with commands missing their data (any command except a newline) are refused, as they cannot be executed.
+ *
+ * @param dst The stream to write the pack to.
+ * @param lists The command lists to save.
+ * @param names Unique names of the lists, used to find them in the loaded pack.
+ * @param count The number of lists.
+ * @return true on success, false on failure (use NapysGetError() to get the error message).
+ */
+bool NapysSaveCommandLists(SDL_IOStream *dst, NapysCommandList *const *lists, const char *const *names, int count);
+
+/**
+ * Load a command pack saved by NapysSaveCommandLists().
+ *
+ * The strings of the commands are used in place, so the data must stay valid and unchanged until the pack
+ * is destroyed, and the commands of all lists are stored in a single allocation.
+ * The returned lists are immutable and owned by the pack: do not destroy them, NapysDestroyCommandList() ignores them.
+ * The lists are bound to the given context: they are compiled against it under its lock, so like the lists
+ * of the template cache they can be executed by renderers of this context on any thread.
+ * Compiling or executing them with another context fails, load the pack once per context instead.
+ * The context must outlive the pack.
+ *
+ * @param ctx The Napys context the lists are compiled against.
+ * @param data The pack contents, aligned to at least 4 bytes (e.g. a memory-mapped file or the result of SDL_LoadFile()).
+ * @param size The size of the data in bytes.
+ * @return A pointer to the loaded pack, or NULL if the data is not a valid pack (use NapysGetError() to get the error message).
+ */
+NapysCommandPack *NapysLoadCommandLists(NapysContext *ctx, const void *data, size_t size);
+
+/**
+ * Get the number of command lists in a command pack.
+ *
+ * @param pack The command pack.
+ * @return The number of lists, 0 if the pack is NULL.
+ */
+int NapysGetCommandPackSize(NapysCommandPack *pack);
+
+/**
+ * Get a command list of a command pack by its index.
+ *
+ * Lists are sorted by their names.
+ *
+ * @param pack The command pack.
+ * @param index The index of the list, from 0 to NapysGetCommandPackSize() - 1.
+ * @param name Optional pointer to store the name of the list in, can be NULL.
+ * @return The command list owned by the pack, or NULL if the index is out of range.
+ */
+NapysCommandList *NapysGetCommandPackList(NapysCommandPack *pack, int index, const char **name);
+
+/**
+ * Find a command list of a command pack by its name.
+ *
+ * @param pack The command pack.
+ * @param name The name the list was saved with.
+ * @return The command list owned by the pack, or NULL if there is no list of this name.
+ */
+NapysCommandList *NapysFindCommandPackList(NapysCommandPack *pack, const char *name);
+
+/**
+ * Destroy a command pack and all of its command lists.
+ *
+ * The lists must not be used by any renderer or layout anymore. The pack data is not freed.
+ *
+ * @param pack The command pack to destroy.
+ */
+void NapysDestroyCommandPack(NapysCommandPack *pack);
+
 #endif
\ No newline at end of file
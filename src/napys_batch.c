@@ -0,0 +1,240 @@
+#include <napys.h>
+#include "napys_internal.h"
+
+// Range of item indices still to be processed by a thread. The owner takes items from the front,
+// other threads steal the back half when they run out of their own work.
+typedef struct
+{
+    SDL_Mutex *lock;
+    int begin;
+    int end;
+} NapysBatchQueue;
+
+typedef struct
+{
+    NapysContext *ctx;
+    const char *const *texts;
+    const NapysRichTextOptions *options;
+    NapysBatchItem *items;
+
+    NapysBatchQueue *queues;
+    int queues_count;
+
+    SDL_AtomicInt failures;
+} NapysBatchJob;
+
+typedef struct
+{
+    NapysBatchJob *job;
+    int index;
+} NapysBatchWorker;
+
+static void NapysProcessBatchItem(NapysBatchJob *job, int index)
+{
+    NapysBatchItem *item = &job->items[index];
+
+    const Uint64 start = SDL_GetTicksNS();
+    item->list = NapysParseRichText(job->texts[index], job->options);
+
+    const NapysContextStats stats = {.parse_ns = SDL_GetTicksNS() - start};
+    NapysAddContextStats(job->ctx, &stats);
+
+    item->layout = item->list ? NapysCreateLayout(job->ctx) : NULL;
+
+    if (!item->layout || !NapysLayoutCommandList(item->layout, item->list))
+    {
+        SDL_AddAtomicInt(&job->failures, 1);
+        return;
+    }
+
+    item->bounds = item->layout->bounds;
+}
+
+static bool NapysPopBatchItem(NapysBatchQueue *queue, int *index)
+{
+    bool result = false;
+
+    SDL_LockMutex(queue->lock);
+
+    if (queue->begin < queue->end)
+    {
+        *index = queue->begin++;
+        result = true;
+    }
+
+    SDL_UnlockMutex(queue->lock);
+
+    return result;
+}
+
+static bool NapysStealBatchItems(NapysBatchJob *job, int thief)
+{
+    for (int i = 1; i < job->queues_count; i++)
+    {
+        NapysBatchQueue *victim = &job->queues[(thief + i) % job->queues_count];
+
+        SDL_LockMutex(victim->lock);
+
+        const int left = victim->end - victim->begin;
+
+        if (left <= 0)
+        {
+            SDL_UnlockMutex(victim->lock);
+            continue;
+        }
+
+        // Take the back half, rounded up so a single remaining item can be stolen as well
+        const int stolen_begin = victim->end - (left + 1) / 2;
+        const int stolen_end = victim->end;
+        victim->end = stolen_begin;
+
+        SDL_UnlockMutex(victim->lock);
+
+        NapysBatchQueue *own = &job->queues[thief];
+
+        SDL_LockMutex(own->lock);
+        own->begin = stolen_begin;
+        own->end = stolen_end;
+        SDL_UnlockMutex(own->lock);
+
+        return true;
+    }
+
+    return false;
+}
+
+static int SDLCALL NapysBatchWorkerThread(void *userdata)
+{
+    NapysBatchWorker *worker = (NapysBatchWorker *)userdata;
+    NapysBatchJob *job = worker->job;
+
+    int index;
+
+    do
+    {
+        while (NapysPopBatchItem(&job->queues[worker->index], &index))
+        {
+            NapysProcessBatchItem(job, index);
+        }
+    } while (NapysStealBatchItems(job, worker->index));
+
+    return 0;
+}
+
+bool NapysParseRichTextBatch(NapysContext *ctx, const char *const *texts, int count, const NapysRichTextOptions *options,
+                             int thread_count, NapysBatchItem *items)
+{
+    if (!ctx || !texts || !items || count < 0 || thread_count < 0)
+    {
+        return NapysSetError("Invalid context, texts, items or thread count");
+    }
+
+    SDL_memset(items, 0, count * sizeof(NapysBatchItem));
+
+    if (count == 0)
+    {
+        return true;
+    }
+
+    if (thread_count == 0)
+    {
+        thread_count = SDL_GetNumLogicalCPUCores();
+    }
+
+    thread_count = SDL_clamp(thread_count, 1, count);
+
+    NapysBatchJob job;
+    job.ctx = ctx;
+    job.texts = texts;
+    job.options = options;
+    job.items = items;
+    job.queues_count = thread_count;
+    SDL_SetAtomicInt(&job.failures, 0);
+
+    job.queues = SDL_calloc(thread_count, sizeof(NapysBatchQueue));
+    NapysBatchWorker *workers = SDL_calloc(thread_count, sizeof(NapysBatchWorker));
+    SDL_Thread **threads = SDL_calloc(thread_count, sizeof(SDL_Thread *));
+
+    if (!job.queues || !workers || !threads)
+    {
+        SDL_free(job.queues);
+        SDL_free(workers);
+        SDL_free(threads);
+        return NapysSetError("Failed to allocate memory for batch workers");
+    }
+
+    bool locks_created = true;
+
+    // Split the items evenly, stealing balances the uneven costs later
+    for (int i = 0; i < thread_count; i++)
+    {
+        job.queues[i].lock = SDL_CreateMutex();
+        job.queues[i].begin = (int)((Sint64)count * i / thread_count);
+        job.queues[i].end = (int)((Sint64)count * (i + 1) / thread_count);
+
+        workers[i].job = &job;
+        workers[i].index = i;
+
+        locks_created = locks_created && job.queues[i].lock;
+    }
+
+    if (locks_created)
+    {
+        // A thread that fails to start just leaves its share to be stolen by the others
+        for (int i = 1; i < thread_count; i++)
+        {
+            threads[i] = SDL_CreateThread(NapysBatchWorkerThread, "NapysBatch", &workers[i]);
+        }
+
+        NapysBatchWorkerThread(&workers[0]);
+
+        for (int i = 1; i < thread_count; i++)
+        {
+            SDL_WaitThread(threads[i], NULL);
+        }
+    }
+
+    for (int i = 0; i < thread_count; i++)
+    {
+        SDL_DestroyMutex(job.queues[i].lock);
+    }
+
+    SDL_free(job.queues);
+    SDL_free(workers);
+    SDL_free(threads);
+
+    if (!locks_created)
+    {
+        return NapysSetError("Failed to create batch worker locks");
+    }
+
+    const int failures = SDL_GetAtomicInt(&job.failures);
+
+    if (failures > 0)
+    {
+        // Errors of the workers are recorded on their own threads, so report just the count
+        char message[128];
+        SDL_snprintf(message, sizeof(message), "Failed to parse or lay out %d of %d texts", failures, count);
+        return NapysSetError(message);
+    }
+
+    return true;
+}
+
+void NapysDestroyBatchItems(NapysBatchItem *items, int count)
+{
+    if (!items)
+    {
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        // Layouts reference the strings of their lists, so they go first
+        NapysDestroyLayout(items[i].layout);
+        NapysDestroyCommandList(items[i].list);
+
+        items[i].layout = NULL;
+        items[i].list = NULL;
+    }
+}
@@ -1,6 +1,15 @@
 #include <napys.h>
 #include "napys_internal.h"
 
+// Shared between all command lists, so a (list, revision) pair is never repeated,
+// even if a destroyed list's memory is reused by a new one.
+static SDL_AtomicInt napys_revision_counter = {0};
+
+Uint32 NapysNextListRevision()
+{
+    return (Uint32)SDL_AddAtomicInt(&napys_revision_counter, 1) + 1;
+}
+
 NapysCommandList *NapysCreateCommandList()
 {
     NapysCommandList *list = SDL_malloc(sizeof(NapysCommandList));
@@ -11,37 +20,56 @@ NapysCommandList *NapysCreateCommandList()
         return NULL;
     }
 
+    list->strings = NapysCreateArena();
+
+    if (!list->strings)
+    {
+        NapysSetError("Failed to allocate memory for command list strings");
+        SDL_free(list);
+        return NULL;
+    }
+
     list->cmds = NULL;
     list->cmd_count = 0;
     list->cmd_capacity = 0;
+    list->compiled_ctx = NULL;
+    list->compiled_generation = 0;
+    list->revision = NapysNextListRevision();
+    SDL_SetAtomicInt(&list->refcount, 1);
+    list->immutable = false;
+    list->pack = NULL;
 
     return list;
 }
 
 void NapysClearCommandList(NapysCommandList *list)
 {
-    if (list)
+    if (list && list->immutable)
     {
-        for (int i = 0; i < list->cmd_count; i++)
-        {
-            if (list->cmds[i].data)
-            {
-                SDL_free(list->cmds[i].data);
-            }
-        }
+        NapysSetError("Command list is immutable");
+    }
+    else if (list)
+    {
+        NapysResetArena(list->strings);
         list->cmd_count = 0;
+        list->compiled_ctx = NULL;
+        list->revision = NapysNextListRevision();
     }
 }
 
 void NapysDestroyCommandList(NapysCommandList *list)
 {
-    if (list != NULL)
+    // Lists of command packs are freed together with their pack
+    if (list != NULL && !list->pack)
     {
-        if (list->cmds != NULL)
+        // SDL_AddAtomicInt() returns the previous value
+        if (SDL_AddAtomicInt(&list->refcount, -1) > 1)
         {
-            NapysClearCommandList(list);
-            SDL_free(list->cmds);
+            return;
         }
+
+        NapysDestroyArena(list->strings);
+        SDL_free(list->cmds);
         SDL_free(list);
     }
 }
@@ -53,6 +81,33 @@ bool NapysAddCommand(NapysCommandList *list, NapysCommand cmd)
         return NapysSetError("Invalid command list");
     }
 
+    return NapysAddCommandWithLength(list, cmd.type, cmd.data, cmd.data ? SDL_strlen(cmd.data) : 0);
+}
+
+bool NapysAddCommandWithLength(NapysCommandList *list, NapysCommandType type, const char *data, size_t length)
+{
+    if (list->immutable)
+    {
+        return NapysSetError("Command list is immutable");
+    }
+
+    char *data_copy = NULL;
+
+    if (data)
+    {
+        data_copy = NapysArenaStrndup(list->strings, data, length);
+        if (!data_copy)
+        {
+            return NapysSetError("Failed to allocate memory for command data");
+        }
+    }
+
+    return NapysPushCommand(list, type, data_copy);
+}
+
+// Appends a command without copying its data, which must already be stored in the list string pool
+bool NapysPushCommand(NapysCommandList *list, NapysCommandType type, char *data)
+{
     if (list->cmd_count >= list->cmd_capacity)
     {
         int new_capacity = list->cmd_capacity == 0 ? 4 : list->cmd_capacity * 2;
@@ -65,9 +120,14 @@ bool NapysAddCommand(NapysCommandList *list, NapysCommand cmd)
         list->cmd_capacity = new_capacity;
     }
 
-    list->cmds[list->cmd_count] = cmd;
+    list->cmds[list->cmd_count].type = type;
+    list->cmds[list->cmd_count].data = data;
+    list->cmds[list->cmd_count].resolved = NULL;
     list->cmd_count++;
 
+    // The new command is not resolved yet
+    list->compiled_ctx = NULL;
+
     return true;
 }
 
@@ -78,11 +138,7 @@ bool NapysAddDrawTextCommand(NapysCommandList *list, const char *text)
         return NapysSetError("Invalid command list or text");
     }
 
-    NapysCommand cmd;
-    cmd.type = NAPYS_COMMAND_TYPE_DRAW_TEXT;
-    cmd.data = SDL_strdup(text);
-
-    return NapysAddCommand(list, cmd);
+    return NapysAddCommandWithLength(list, NAPYS_COMMAND_TYPE_DRAW_TEXT, text, SDL_strlen(text));
 }
 
 bool NapysAddSetColorCommand(NapysCommandList *list, const char *color_name)
@@ -90,11 +146,7 @@ bool NapysAddSetColorCommand(NapysCommandList *list, const char *color_name)
     if (!list || !color_name)
         return NapysSetError("Invalid command list");
 
-    NapysCommand cmd;
-    cmd.type = NAPYS_COMMAND_TYPE_SET_COLOR;
-    cmd.data = SDL_strdup(color_name);
-
-    return NapysAddCommand(list, cmd);
+    return NapysAddCommandWithLength(list, NAPYS_COMMAND_TYPE_SET_COLOR, color_name, SDL_strlen(color_name));
 }
 
 bool NapysAddSetFontCommand(NapysCommandList *list, const char *color_name)
@@ -102,11 +154,7 @@ bool NapysAddSetFontCommand(NapysCommandList *list, const char *color_name)
     if (!list || !color_name)
         return NapysSetError("Invalid command list");
 
-    NapysCommand cmd;
-    cmd.type = NAPYS_COMMAND_TYPE_SET_FONT;
-    cmd.data = SDL_strdup(color_name);
-
-    return NapysAddCommand(list, cmd);
+    return NapysAddCommandWithLength(list, NAPYS_COMMAND_TYPE_SET_FONT, color_name, SDL_strlen(color_name));
 }
 
 bool NapysAddSetSizeCommand(NapysCommandList *list, const char *size_name)
@@ -114,11 +162,7 @@ bool NapysAddSetSizeCommand(NapysCommandList *list, const char *size_name)
     if (!list || !size_name)
         return NapysSetError("Invalid command list");
 
-    NapysCommand cmd;
-    cmd.type = NAPYS_COMMAND_TYPE_SET_SIZE;
-    cmd.data = SDL_strdup(size_name);
-
-    return NapysAddCommand(list, cmd);
+    return NapysAddCommandWithLength(list, NAPYS_COMMAND_TYPE_SET_SIZE, size_name, SDL_strlen(size_name));
 }
 
 bool NapysAddNewlineCommand(NapysCommandList *list)
@@ -126,11 +170,7 @@ bool NapysAddNewlineCommand(NapysCommandList *list)
     if (!list)
         return NapysSetError("Invalid command list");
 
-    NapysCommand cmd;
-    cmd.type = NAPYS_COMMAND_TYPE_NEWLINE;
-    cmd.data = NULL;
-
-    return NapysAddCommand(list, cmd);
+    return NapysAddCommandWithLength(list, NAPYS_COMMAND_TYPE_NEWLINE, NULL, 0);
 }
 
 bool NapysAddDrawImageCommand(NapysCommandList *list, const char *image_name)
@@ -138,11 +178,7 @@ bool NapysAddDrawImageCommand(NapysCommandList *list, const char *image_name)
     if (!list || !image_name)
         return NapysSetError("Invalid command list or image name");
 
-    NapysCommand cmd;
-    cmd.type = NAPYS_COMMAND_TYPE_DRAW_IMAGE;
-    cmd.data = SDL_strdup(image_name);
-
-    return NapysAddCommand(list, cmd);
+    return NapysAddCommandWithLength(list, NAPYS_COMMAND_TYPE_DRAW_IMAGE, image_name, SDL_strlen(image_name));
 }
 
 bool NapysAddUseStringCommand(NapysCommandList *list, const char *key)
@@ -150,9 +186,124 @@ bool NapysAddUseStringCommand(NapysCommandList *list, const char *key)
     if (!list || !key)
         return NapysSetError("Invalid command list or key");
 
-    NapysCommand cmd;
-    cmd.type = NAPYS_COMMAND_TYPE_USE_STRING;
-    cmd.data = SDL_strdup(key);
+    return NapysAddCommandWithLength(list, NAPYS_COMMAND_TYPE_USE_STRING, key, SDL_strlen(key));
+}
+
+bool NapysAddSetAlignCommand(NapysCommandList *list, const char *align_name)
+{
+    if (!list || !align_name)
+        return NapysSetError("Invalid command list or alignment name");
+
+    return NapysAddCommandWithLength(list, NAPYS_COMMAND_TYPE_SET_ALIGN, align_name, SDL_strlen(align_name));
+}
+
+static void *NapysResolveRegistryEntry(NapysContext *ctx, const char *key, NapysRegistryEntryType type)
+{
+    NapysRegistryEntry *entry = (NapysRegistryEntry *)NapysHashmapFind(ctx->registry, key);
+
+    if (entry && entry->type == type)
+    {
+        return entry;
+    }
+
+    return NULL;
+}
+
+static void NapysResolveCommands(NapysContext *ctx, NapysCommandList *list)
+{
+    NapysContextStats stats = {0};
+
+    for (int i = 0; i < list->cmd_count; i++)
+    {
+        NapysCommand *cmd = &list->cmds[i];
+
+        switch (cmd->type)
+        {
+        case NAPYS_COMMAND_TYPE_SET_COLOR:
+            cmd->resolved = NapysResolveRegistryEntry(ctx, cmd->data, NAPYS_REGISTRY_ENTRY_COLOR);
+            break;
+        case NAPYS_COMMAND_TYPE_SET_SIZE:
+            cmd->resolved = NapysResolveRegistryEntry(ctx, cmd->data, NAPYS_REGISTRY_ENTRY_SIZE);
+            break;
+        case NAPYS_COMMAND_TYPE_DRAW_IMAGE:
+            cmd->resolved = NapysResolveRegistryEntry(ctx, cmd->data, NAPYS_REGISTRY_ENTRY_IMAGE);
+            break;
+        case NAPYS_COMMAND_TYPE_USE_STRING:
+            cmd->resolved = NapysResolveRegistryEntry(ctx, cmd->data, NAPYS_REGISTRY_ENTRY_STRING);
+            break;
+        case NAPYS_COMMAND_TYPE_SET_FONT:
+            cmd->resolved = NapysHashmapGetPointer(ctx->fonts, cmd->data);
+            break;
+        default:
+            cmd->resolved = NULL;
+            continue;
+        }
+
+        stats.registry_lookups++;
+
+        if (!cmd->resolved)
+        {
+            stats.registry_misses++;
+        }
+    }
+
+    // Counted once per list, so concurrent compilations do not contend on every lookup
+    NapysAddContextStats(ctx, &stats);
+
+    list->compiled_ctx = ctx;
+    list->compiled_generation = ctx->generation;
+}
+
+bool NapysCompileCommandList(NapysContext *ctx, NapysCommandList *list)
+{
+    if (!ctx || !list)
+    {
+        return NapysSetError("Invalid context or command list");
+    }
+
+    if (list->pack && NapysGetCommandPackContext(list->pack) != ctx)
+    {
+        return NapysSetError("Command pack lists can only be compiled against the context the pack was loaded with");
+    }
 
-    return NapysAddCommand(list, cmd);
-}
\ No newline at end of file
+    // Immutable lists are shared by the template cache and may be used by several threads at once
+    if (list->immutable)
+    {
+        SDL_LockMutex(ctx->lock);
+        NapysResolveCommands(ctx, list);
+        SDL_UnlockMutex(ctx->lock);
+    }
+    else
+    {
+        NapysResolveCommands(ctx, list);
+    }
+
+    return true;
+}
+
+bool NapysEnsureCommandListCompiled(NapysContext *ctx, NapysCommandList *list)
+{
+    // Packs are shared by all their users, so resolving them against several contexts would overwrite each other
+    if (list->pack && NapysGetCommandPackContext(list->pack) != ctx)
+    {
+        return NapysSetError("Command pack lists can only be compiled against the context the pack was loaded with");
+    }
+
+    // Only one of the threads using a shared list may compile it, and the others must wait for the result
+    if (list->immutable)
+    {
+        SDL_LockMutex(ctx->lock);
+    }
+
+    if (list->compiled_ctx != ctx || list->compiled_generation != ctx->generation)
+    {
+        NapysResolveCommands(ctx, list);
+    }
+
+    if (list->immutable)
+    {
+        SDL_UnlockMutex(ctx->lock);
+    }
+
+    return true;
+}
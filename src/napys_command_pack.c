@@ -0,0 +1,359 @@
+#include <napys.h>
+#include "napys_internal.h"
+
+// Pack layout, all integers are little-endian Uint32:
+//   header:   magic, version, lists count, commands count, strings size
+//   lists:    name offset, first command, commands count (sorted by name)
+//   commands: type, data offset (NAPYS_PACK_NO_DATA for commands without data)
+//   strings:  null-terminated names of all lists, then data of all commands
+#define NAPYS_PACK_MAGIC SDL_FOURCC('N', 'P', 'C', 'K')
+#define NAPYS_PACK_NO_DATA 0xFFFFFFFFu
+
+#define NAPYS_PACK_HEADER_WORDS 5
+#define NAPYS_PACK_LIST_WORDS 3
+#define NAPYS_PACK_COMMAND_WORDS 2
+
+struct NapysCommandPack
+{
+    NapysContext *ctx; // The only context the lists are compiled against
+
+    NapysCommandList *lists; // Sorted by name
+    const char **names;
+    int lists_count;
+
+    NapysCommand *commands; // Commands of all lists, each list uses a range of them
+};
+
+static int SDLCALL NapysCompareListNames(void *userdata, const void *a, const void *b)
+{
+    const char *const *names = (const char *const *)userdata;
+
+    return SDL_strcmp(names[*(const int *)a], names[*(const int *)b]);
+}
+
+// Every command except a newline reads its data, so a pack must never leave it out
+static bool NapysCommandNeedsData(Uint32 type)
+{
+    return type != NAPYS_COMMAND_TYPE_NEWLINE;
+}
+
+static bool NapysWritePackString(SDL_IOStream *dst, const char *str)
+{
+    return SDL_WriteIO(dst, str, SDL_strlen(str) + 1) == SDL_strlen(str) + 1;
+}
+
+bool NapysSaveCommandLists(SDL_IOStream *dst, NapysCommandList *const *lists, const char *const *names, int count)
+{
+    if (!dst || !lists || !names || count < 0)
+    {
+        return NapysSetError("Invalid stream, lists, names or count");
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!lists[i] || !names[i])
+        {
+            return NapysSetError("Invalid command list or name");
+        }
+
+        for (int c = 0; c < lists[i]->cmd_count; c++)
+        {
+            if (!lists[i]->cmds[c].data && NapysCommandNeedsData(lists[i]->cmds[c].type))
+            {
+                return NapysSetError("Command list contains a command without data");
+            }
+        }
+    }
+
+    int *order = SDL_malloc((count > 0 ? count : 1) * sizeof(int));
+
+    if (!order)
+    {
+        return NapysSetError("Failed to allocate memory for command pack");
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        order[i] = i;
+    }
+
+    SDL_qsort_r(order, count, sizeof(int), NapysCompareListNames, (void *)names);
+
+    // Sizes are computed in 64 bits, so packs too large for the format are detected
+    Uint64 commands_count = 0;
+    Uint64 names_size = 0;
+    Uint64 strings_size = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (i > 0 && SDL_strcmp(names[order[i - 1]], names[order[i]]) == 0)
+        {
+            SDL_free(order);
+            return NapysSetError("Command list names must be unique");
+        }
+
+        const NapysCommandList *list = lists[order[i]];
+
+        commands_count += list->cmd_count;
+        names_size += SDL_strlen(names[order[i]]) + 1;
+
+        for (int c = 0; c < list->cmd_count; c++)
+        {
+            if (list->cmds[c].data)
+            {
+                strings_size += SDL_strlen(list->cmds[c].data) + 1;
+            }
+        }
+    }
+
+    strings_size += names_size;
+
+    if (commands_count >= NAPYS_PACK_NO_DATA || strings_size >= NAPYS_PACK_NO_DATA)
+    {
+        SDL_free(order);
+        return NapysSetError("Command lists are too large for a command pack");
+    }
+
+    bool ok = SDL_WriteU32LE(dst, NAPYS_PACK_MAGIC) && SDL_WriteU32LE(dst, NAPYS_COMMAND_PACK_VERSION) &&
+              SDL_WriteU32LE(dst, (Uint32)count) && SDL_WriteU32LE(dst, (Uint32)commands_count) &&
+              SDL_WriteU32LE(dst, (Uint32)strings_size);
+
+    Uint32 name_offset = 0;
+    Uint32 first_command = 0;
+
+    for (int i = 0; ok && i < count; i++)
+    {
+        const NapysCommandList *list = lists[order[i]];
+
+        ok = SDL_WriteU32LE(dst, name_offset) && SDL_WriteU32LE(dst, first_command) &&
+             SDL_WriteU32LE(dst, (Uint32)list->cmd_count);
+
+        name_offset += (Uint32)SDL_strlen(names[order[i]]) + 1;
+        first_command += (Uint32)list->cmd_count;
+    }
+
+    Uint32 data_offset = (Uint32)names_size;
+
+    for (int i = 0; ok && i < count; i++)
+    {
+        const NapysCommandList *list = lists[order[i]];
+
+        for (int c = 0; ok && c < list->cmd_count; c++)
+        {
+            const NapysCommand *cmd = &list->cmds[c];
+
+            ok = SDL_WriteU32LE(dst, (Uint32)cmd->type) && SDL_WriteU32LE(dst, cmd->data ? data_offset : NAPYS_PACK_NO_DATA);
+
+            if (cmd->data)
+            {
+                data_offset += (Uint32)SDL_strlen(cmd->data) + 1;
+            }
+        }
+    }
+
+    for (int i = 0; ok && i < count; i++)
+    {
+        ok = NapysWritePackString(dst, names[order[i]]);
+    }
+
+    for (int i = 0; ok && i < count; i++)
+    {
+        const NapysCommandList *list = lists[order[i]];
+
+        for (int c = 0; ok && c < list->cmd_count; c++)
+        {
+            ok = !list->cmds[c].data || NapysWritePackString(dst, list->cmds[c].data);
+        }
+    }
+
+    SDL_free(order);
+
+    if (!ok)
+    {
+        return NapysSetError("Failed to write command pack");
+    }
+
+    return true;
+}
+
+NapysCommandPack *NapysLoadCommandLists(NapysContext *ctx, const void *data, size_t size)
+{
+    if (!ctx || !data || ((uintptr_t)data & 3) != 0)
+    {
+        NapysSetError("Invalid context or unaligned command pack data");
+        return NULL;
+    }
+
+    const Uint32 *words = (const Uint32 *)data;
+
+    if (size < NAPYS_PACK_HEADER_WORDS * sizeof(Uint32) || SDL_Swap32LE(words[0]) != NAPYS_PACK_MAGIC)
+    {
+        NapysSetError("Not a command pack");
+        return NULL;
+    }
+
+    if (SDL_Swap32LE(words[1]) != NAPYS_COMMAND_PACK_VERSION)
+    {
+        NapysSetError("Unsupported command pack version");
+        return NULL;
+    }
+
+    const Uint32 lists_count = SDL_Swap32LE(words[2]);
+    const Uint32 commands_count = SDL_Swap32LE(words[3]);
+    const Uint32 strings_size = SDL_Swap32LE(words[4]);
+
+    const Uint64 tables_words = NAPYS_PACK_HEADER_WORDS + (Uint64)lists_count * NAPYS_PACK_LIST_WORDS +
+                                (Uint64)commands_count * NAPYS_PACK_COMMAND_WORDS;
+
+    if (lists_count > SDL_MAX_SINT32 || commands_count > SDL_MAX_SINT32 ||
+        tables_words * sizeof(Uint32) + strings_size > size)
+    {
+        NapysSetError("Command pack is truncated");
+        return NULL;
+    }
+
+    const Uint32 *list_words = words + NAPYS_PACK_HEADER_WORDS;
+    const Uint32 *command_words = list_words + (size_t)lists_count * NAPYS_PACK_LIST_WORDS;
+    const char *strings = (const char *)(command_words + (size_t)commands_count * NAPYS_PACK_COMMAND_WORDS);
+
+    // Every offset points before the final terminator, so all strings are terminated within the table
+    if (strings_size > 0 && strings[strings_size - 1] != '\0')
+    {
+        NapysSetError("Command pack string table is not terminated");
+        return NULL;
+    }
+
+    // The pack, its lists and all commands share a single allocation
+    NapysCommandPack *pack = SDL_malloc(sizeof(NapysCommandPack) + lists_count * sizeof(NapysCommandList) +
+                                        lists_count * sizeof(const char *) + commands_count * sizeof(NapysCommand));
+
+    if (!pack)
+    {
+        NapysSetError("Failed to allocate memory for command pack");
+        return NULL;
+    }
+
+    pack->ctx = ctx;
+    pack->lists = (NapysCommandList *)(pack + 1);
+    pack->names = (const char **)(pack->lists + lists_count);
+    pack->commands = (NapysCommand *)(pack->names + lists_count);
+    pack->lists_count = (int)lists_count;
+
+    for (Uint32 i = 0; i < commands_count; i++)
+    {
+        const Uint32 type = SDL_Swap32LE(command_words[i * NAPYS_PACK_COMMAND_WORDS]);
+        const Uint32 offset = SDL_Swap32LE(command_words[i * NAPYS_PACK_COMMAND_WORDS + 1]);
+
+        if (type > NAPYS_COMMAND_TYPE_SET_ALIGN || (offset == NAPYS_PACK_NO_DATA && NapysCommandNeedsData(type)) ||
+            (offset != NAPYS_PACK_NO_DATA && offset >= strings_size))
+        {
+            SDL_free(pack);
+            NapysSetError("Command pack contains an invalid command");
+            return NULL;
+        }
+
+        // The data is never modified, it is only typed as mutable for lists built at runtime
+        pack->commands[i].type = (NapysCommandType)type;
+        pack->commands[i].data = offset == NAPYS_PACK_NO_DATA ? NULL : (char *)(strings + offset);
+        pack->commands[i].resolved = NULL;
+    }
+
+    for (Uint32 i = 0; i < lists_count; i++)
+    {
+        const Uint32 name_offset = SDL_Swap32LE(list_words[i * NAPYS_PACK_LIST_WORDS]);
+        const Uint32 first_command = SDL_Swap32LE(list_words[i * NAPYS_PACK_LIST_WORDS + 1]);
+        const Uint32 cmd_count = SDL_Swap32LE(list_words[i * NAPYS_PACK_LIST_WORDS + 2]);
+
+        // Names must be sorted for NapysFindCommandPackList()
+        if (name_offset >= strings_size || first_command > commands_count || cmd_count > commands_count - first_command ||
+            (i > 0 && SDL_strcmp(pack->names[i - 1], strings + name_offset) >= 0))
+        {
+            SDL_free(pack);
+            NapysSetError("Command pack contains an invalid list");
+            return NULL;
+        }
+
+        NapysCommandList *list = &pack->lists[i];
+
+        list->cmds = pack->commands + first_command;
+        list->cmd_count = (int)cmd_count;
+        list->cmd_capacity = (int)cmd_count;
+        list->strings = NULL;
+        SDL_SetAtomicInt(&list->refcount, 1);
+        list->immutable = true;
+        list->compiled_ctx = NULL;
+        list->compiled_generation = 0;
+        list->revision = NapysNextListRevision();
+        list->pack = pack;
+
+        pack->names[i] = strings + name_offset;
+    }
+
+    return pack;
+}
+
+const NapysContext *NapysGetCommandPackContext(const NapysCommandPack *pack)
+{
+    return pack->ctx;
+}
+
+int NapysGetCommandPackSize(NapysCommandPack *pack)
+{
+    return pack ? pack->lists_count : 0;
+}
+
+NapysCommandList *NapysGetCommandPackList(NapysCommandPack *pack, int index, const char **name)
+{
+    if (!pack || index < 0 || index >= pack->lists_count)
+    {
+        NapysSetError("Invalid command pack or list index");
+        return NULL;
+    }
+
+    if (name)
+    {
+        *name = pack->names[index];
+    }
+
+    return &pack->lists[index];
+}
+
+NapysCommandList *NapysFindCommandPackList(NapysCommandPack *pack, const char *name)
+{
+    if (!pack || !name)
+    {
+        NapysSetError("Invalid command pack or name");
+        return NULL;
+    }
+
+    int low = 0;
+    int high = pack->lists_count;
+
+    while (low < high)
+    {
+        const int middle = low + (high - low) / 2;
+        const int order = SDL_strcmp(pack->names[middle], name);
+
+        if (order == 0)
+        {
+            return &pack->lists[middle];
+        }
+
+        if (order < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    NapysSetError("Command list not found in command pack");
+    return NULL;
+}
+
+void NapysDestroyCommandPack(NapysCommandPack *pack)
+{
+    SDL_free(pack);
+}
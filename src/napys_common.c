@@ -3,39 +3,182 @@
 
 #include <SDL3/SDL.h>
 
-static char napys_error[512] = {0};
+#define NAPYS_ERROR_MAX_LENGTH 512
+
+// Every thread gets its own error buffer, so errors of concurrent calls do not overwrite each other
+static SDL_TLSID napys_error_tls;
+
+static char *NapysGetErrorBuffer(void)
+{
+    char *buffer = (char *)SDL_GetTLS(&napys_error_tls);
+
+    if (!buffer)
+    {
+        buffer = SDL_calloc(1, NAPYS_ERROR_MAX_LENGTH);
+
+        if (buffer && !SDL_SetTLS(&napys_error_tls, buffer, SDL_free))
+        {
+            SDL_free(buffer);
+            buffer = NULL;
+        }
+    }
+
+    return buffer;
+}
 
 const char *NapysGetError()
 {
-    return napys_error;
+    const char *buffer = NapysGetErrorBuffer();
+
+    return buffer ? buffer : "Out of memory";
 }
 
 bool NapysSetError(const char *message)
 {
+    char *buffer = NapysGetErrorBuffer();
+
+    if (!buffer)
+    {
+        return false;
+    }
+
     if (message == NULL)
     {
-        napys_error[0] = '\0';
+        buffer[0] = '\0';
     }
     else
     {
-        SDL_strlcpy(napys_error, message, sizeof(napys_error));
+        SDL_strlcpy(buffer, message, NAPYS_ERROR_MAX_LENGTH);
     }
 
     return false;
 }
 
-NapysHashmap *NapysCreateHashmap()
+#ifdef NAPYS_PROFILING
+
+static NapysProfilingHooks napys_profiling_hooks;
+
+void NapysBeginProfilingZone(const char *name, const void *label)
+{
+    if (napys_profiling_hooks.begin_zone)
+    {
+        napys_profiling_hooks.begin_zone(napys_profiling_hooks.userdata, name, (Uint64)(uintptr_t)label);
+    }
+}
+
+void NapysEndProfilingZone(const char *name, const void *label)
 {
-    NapysHashmap *map = SDL_malloc(sizeof(NapysHashmap));
+    if (napys_profiling_hooks.end_zone)
+    {
+        napys_profiling_hooks.end_zone(napys_profiling_hooks.userdata, name, (Uint64)(uintptr_t)label);
+    }
+}
+
+bool NapysSetProfilingHooks(const NapysProfilingHooks *hooks)
+{
+    if (hooks)
+    {
+        napys_profiling_hooks = *hooks;
+    }
+    else
+    {
+        SDL_zero(napys_profiling_hooks);
+    }
+
+    return true;
+}
+
+#else
+
+bool NapysSetProfilingHooks(const NapysProfilingHooks *hooks)
+{
+    return NapysSetError("Napys was built without profiling support (NAPYS_PROFILING)");
+}
+
+#endif
+
+#define NAPYS_HASHMAP_INITIAL_CAPACITY 16
+
+static Uint32 NapysHashKey(const char *key)
+{
+    const Uint32 hash = SDL_murmur3_32(key, SDL_strlen(key), 0);
+
+    // 0 marks empty slots
+    return hash != 0 ? hash : 1;
+}
+
+// Find the slot of the key, or the empty slot where it would be inserted
+static Uint32 NapysFindHashmapSlot(const NapysHashmap *map, const char *key, Uint32 hash)
+{
+    const Uint32 mask = map->capacity - 1;
+    Uint32 slot = hash & mask;
+
+    // The map is never full, so the probing always ends on an empty slot
+    while (map->hashes[slot] != 0 && (map->hashes[slot] != hash || SDL_strcmp(map->keys[slot], key) != 0))
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+static bool NapysResizeHashmap(NapysHashmap *map, Uint32 capacity)
+{
+    Uint32 *hashes = SDL_calloc(capacity, sizeof(Uint32));
+    char **keys = SDL_calloc(capacity, sizeof(char *));
+    Uint8 *values = SDL_calloc(capacity, map->value_size);
+
+    if (!hashes || !keys || !values)
+    {
+        SDL_free(hashes);
+        SDL_free(keys);
+        SDL_free(values);
+        return false;
+    }
+
+    NapysHashmap resized = *map;
+    resized.hashes = hashes;
+    resized.keys = keys;
+    resized.values = values;
+    resized.capacity = capacity;
+
+    // The hashes are kept, so rehashing never touches the keys unless slots collide
+    for (Uint32 i = 0; i < map->capacity; i++)
+    {
+        if (map->hashes[i] != 0)
+        {
+            const Uint32 slot = NapysFindHashmapSlot(&resized, map->keys[i], map->hashes[i]);
+
+            hashes[slot] = map->hashes[i];
+            keys[slot] = map->keys[i];
+            SDL_memcpy(values + slot * map->value_size, map->values + i * map->value_size, map->value_size);
+        }
+    }
+
+    SDL_free(map->hashes);
+    SDL_free(map->keys);
+    SDL_free(map->values);
+
+    *map = resized;
+
+    return true;
+}
+
+NapysHashmap *NapysCreateHashmap(size_t value_size)
+{
+    NapysHashmap *map = SDL_calloc(1, sizeof(NapysHashmap));
+
     if (map != NULL)
     {
-        map->data = SDL_CreateProperties();
-        if (map->data == 0)
+        map->value_size = value_size;
+
+        if (!NapysResizeHashmap(map, NAPYS_HASHMAP_INITIAL_CAPACITY))
         {
             SDL_free(map);
             return NULL;
         }
     }
+
     return map;
 }
 
@@ -43,42 +186,209 @@ void NapysDestroyHashmap(NapysHashmap *map)
 {
     if (map != NULL)
     {
-        SDL_DestroyProperties(map->data);
+        for (Uint32 i = 0; i < map->capacity; i++)
+        {
+            SDL_free(map->keys[i]);
+        }
+
+        SDL_free(map->hashes);
+        SDL_free(map->keys);
+        SDL_free(map->values);
         SDL_free(map);
     }
 }
 
-void NapysHashmapStorePointer(NapysHashmap *map, const char *key, void *value)
+void *NapysHashmapInsert(NapysHashmap *map, const char *key, bool *inserted)
 {
-    if (map != NULL && key != NULL && value != NULL)
+    if (map == NULL || key == NULL)
+    {
+        return NULL;
+    }
+
+    const Uint32 hash = NapysHashKey(key);
+    Uint32 slot = NapysFindHashmapSlot(map, key, hash);
+
+    if (map->hashes[slot] != 0)
     {
-        SDL_SetPointerProperty(map->data, key, value);
+        *inserted = false;
+        return map->values + slot * map->value_size;
     }
+
+    // Keep the load factor at most 3/4, so probe sequences stay short
+    if ((map->count + 1) * 4 > map->capacity * 3)
+    {
+        if (!NapysResizeHashmap(map, map->capacity * 2))
+        {
+            return NULL;
+        }
+
+        slot = NapysFindHashmapSlot(map, key, hash);
+    }
+
+    char *key_copy = SDL_strdup(key);
+
+    if (!key_copy)
+    {
+        return NULL;
+    }
+
+    map->hashes[slot] = hash;
+    map->keys[slot] = key_copy;
+    map->count++;
+
+    *inserted = true;
+    return map->values + slot * map->value_size;
 }
 
-void *NapysHashmapGetPointer(NapysHashmap *map, const char *key)
+void *NapysHashmapFind(const NapysHashmap *map, const char *key)
 {
-    if (map != NULL && key != NULL)
+    if (map == NULL || key == NULL)
     {
-        return SDL_GetPointerProperty(map->data, key, NULL);
+        return NULL;
     }
-    return NULL;
+
+    const Uint32 slot = NapysFindHashmapSlot(map, key, NapysHashKey(key));
+
+    return map->hashes[slot] != 0 ? map->values + slot * map->value_size : NULL;
 }
 
-static void NapysHashmapCallbackWrapper(void *userdata, SDL_PropertiesID props, const char *name)
+void NapysHashmapStorePointer(NapysHashmap *map, const char *key, void *value)
 {
-    NapysHashmapCallback callback = (NapysHashmapCallback)userdata;
+    bool inserted;
+    void **slot = (void **)NapysHashmapInsert(map, key, &inserted);
 
-    callback(name, SDL_GetPointerProperty(props, name, NULL), userdata);
+    if (slot != NULL)
+    {
+        *slot = value;
+    }
 }
 
-void *NapysIterateHashmap(NapysHashmap *map, NapysHashmapCallback callback, void *userdata)
+void *NapysHashmapGetPointer(const NapysHashmap *map, const char *key)
+{
+    void **slot = (void **)NapysHashmapFind(map, key);
+
+    return slot != NULL ? *slot : NULL;
+}
+
+void NapysIterateHashmap(NapysHashmap *map, NapysHashmapCallback callback, void *userdata)
 {
     if (map == NULL || callback == NULL)
     {
-        return NULL;
+        return;
+    }
+
+    for (Uint32 i = 0; i < map->capacity; i++)
+    {
+        if (map->hashes[i] != 0)
+        {
+            callback(map->keys[i], map->values + i * map->value_size, userdata);
+        }
+    }
+}
+
+NapysArena *NapysCreateArena()
+{
+    NapysArena *arena = SDL_malloc(sizeof(NapysArena));
+    if (arena != NULL)
+    {
+        arena->first = NULL;
+        arena->current = NULL;
+    }
+    return arena;
+}
+
+char *NapysArenaAlloc(NapysArena *arena, size_t size)
+{
+    NapysArenaBlock *block = arena->current;
+
+    // Move on to the next already allocated block, until one has enough space left
+    while (block && block->used + size > block->capacity)
+    {
+        block = block->next;
+
+        if (block)
+        {
+            block->used = 0;
+        }
     }
 
-    SDL_EnumerateProperties(map->data, NapysHashmapCallbackWrapper, callback);
-    return NULL;
-}
\ No newline at end of file
+    if (!block)
+    {
+        size_t capacity = size > NAPYS_ARENA_BLOCK_SIZE ? size : NAPYS_ARENA_BLOCK_SIZE;
+
+        block = SDL_malloc(sizeof(NapysArenaBlock) + capacity);
+        if (!block)
+        {
+            return NULL;
+        }
+
+        block->capacity = capacity;
+        block->used = 0;
+
+        // Blocks skipped above stay in the chain, to be reused after the next reset
+        if (arena->current)
+        {
+            NapysArenaBlock *last = arena->current;
+            while (last->next)
+            {
+                last = last->next;
+            }
+
+            block->next = NULL;
+            last->next = block;
+        }
+        else
+        {
+            block->next = arena->first;
+            arena->first = block;
+        }
+    }
+
+    arena->current = block;
+
+    char *ptr = block->data + block->used;
+    block->used += size;
+
+    return ptr;
+}
+
+char *NapysArenaStrndup(NapysArena *arena, const char *str, size_t length)
+{
+    char *copy = NapysArenaAlloc(arena, length + 1);
+
+    if (copy)
+    {
+        SDL_memcpy(copy, str, length);
+        copy[length] = '\0';
+    }
+
+    return copy;
+}
+
+void NapysResetArena(NapysArena *arena)
+{
+    if (arena != NULL)
+    {
+        arena->current = arena->first;
+
+        if (arena->current)
+        {
+            arena->current->used = 0;
+        }
+    }
+}
+
+void NapysDestroyArena(NapysArena *arena)
+{
+    if (arena != NULL)
+    {
+        NapysArenaBlock *block = arena->first;
+        while (block)
+        {
+            NapysArenaBlock *next = block->next;
+            SDL_free(block);
+            block = next;
+        }
+        SDL_free(arena);
+    }
+}
@@ -1,99 +1,122 @@
 #include <napys.h>
 #include "napys_internal.h"
 
+// Shared between all contexts, so a (context, generation) pair is never repeated,
+// even if a destroyed context's memory is reused by a new one.
+static SDL_AtomicInt napys_generation_counter = {0};
+
+void NapysBumpContextGeneration(NapysContext *ctx)
+{
+    ctx->generation = (Uint32)SDL_AddAtomicInt(&napys_generation_counter, 1) + 1;
+}
+
+void NapysAddContextStats(NapysContext *ctx, const NapysContextStats *delta)
+{
+    SDL_LockSpinlock(&ctx->stats_lock);
+
+    ctx->stats.registry_lookups += delta->registry_lookups;
+    ctx->stats.registry_misses += delta->registry_misses;
+    ctx->stats.parse_ns += delta->parse_ns;
+    ctx->stats.layout_ns += delta->layout_ns;
+
+    SDL_UnlockSpinlock(&ctx->stats_lock);
+}
+
 NapysContext *NapysCreateContext()
 {
-    NapysContext *ctx = SDL_malloc(sizeof(NapysContext));
+    NapysContext *ctx = SDL_calloc(1, sizeof(NapysContext));
 
     if (!ctx)
         return NULL;
 
-    ctx->registry = NapysCreateHashmap();
-    ctx->fonts = NapysCreateHashmap();
+    ctx->registry = NapysCreateHashmap(sizeof(NapysRegistryEntry));
+    ctx->fonts = NapysCreateHashmap(sizeof(NapysFontCache *));
+    ctx->lock = SDL_CreateMutex();
 
-    if (!ctx->registry || !ctx->fonts)
+    if (!ctx->registry || !ctx->fonts || !ctx->lock)
     {
-        NapysSetError("Failed to create context: could not allocate hashmaps");
+        NapysSetError("Failed to create context: could not allocate hashmaps or lock");
 
+        NapysDestroyHashmap(ctx->registry);
+        NapysDestroyHashmap(ctx->fonts);
+        SDL_DestroyMutex(ctx->lock);
         SDL_free(ctx);
         return NULL;
     }
 
+    ctx->font_budget.max_sizes = NAPYS_DEFAULT_FONT_CACHE_MAX_SIZES;
+    ctx->font_budget.max_bytes = NAPYS_DEFAULT_FONT_CACHE_MAX_BYTES;
+
+    NapysBumpContextGeneration(ctx);
+
     return ctx;
 }
 
+static void NapysFreeRegistryEntryCallback(const char *key, void *value, void *userdata)
+{
+    NapysRegistryEntry *entry = (NapysRegistryEntry *)value;
+    SDL_free(entry->str);
+}
+
 static void NapysDestroyFontCacheCallback(const char *key, void *value, void *userdata)
 {
     if (value != NULL)
     {
-        NapysFontCache *cache = (NapysFontCache *)value;
+        NapysFontCache *cache = *(NapysFontCache **)value;
         NapysDestroyFontCache(cache);
     }
 }
 
-NapysFontCache *NapysCreateFontCache(TTF_Font *fnt)
+static void NapysSumFontCopiesCallback(const char *key, void *value, void *userdata)
 {
-    NapysFontCache *cache = SDL_malloc(sizeof(NapysFontCache));
-
-    if (!cache)
-    {
-        NapysSetError("Failed to allocate memory for font cache");
-        return NULL;
-    }
-
-    cache->base = fnt;
+    NapysFontCache *cache = *(NapysFontCache **)value;
+    NapysContextStats *stats = (NapysContextStats *)userdata;
 
-    for (int i = 0; i < NAPYS_MAX_FONT_SIZE; i++)
-    {
-        cache->sizes[i] = NULL;
-    }
-
-    int ptsize = TTF_GetFontSize(fnt);
-
-    cache->sizes[ptsize] = fnt;
-    return cache;
+    SDL_LockMutex(cache->lock);
+    stats->font_copies += cache->copies;
+    SDL_UnlockMutex(cache->lock);
 }
 
-TTF_Font *NapysQueryFontCache(NapysFontCache *cache, int ptsize)
+bool NapysGetContextStats(NapysContext *ctx, NapysContextStats *stats)
 {
-    if (!cache || ptsize < 0 || ptsize >= NAPYS_MAX_FONT_SIZE)
+    if (!ctx || !stats)
     {
-        return NULL;
+        return NapysSetError("Invalid context or stats");
     }
 
-    // If the requested size is already cached, return it
-    if (cache->sizes[ptsize])
-    {
-        return cache->sizes[ptsize];
-    }
+    SDL_LockSpinlock(&ctx->stats_lock);
+    *stats = ctx->stats;
+    SDL_UnlockSpinlock(&ctx->stats_lock);
 
-    TTF_Font *new_font = TTF_CopyFont(cache->base);
+    stats->font_copies = 0;
+    NapysIterateHashmap(ctx->fonts, NapysSumFontCopiesCallback, stats);
 
-    if (!new_font)
-    {
-        NapysSetError("Failed to copy font");
-        return NULL;
-    }
+    return true;
+}
 
-    TTF_SetFontSize(new_font, ptsize);
-    cache->sizes[ptsize] = new_font;
+static void NapysResetFontCopiesCallback(const char *key, void *value, void *userdata)
+{
+    NapysFontCache *cache = *(NapysFontCache **)value;
 
-    return new_font;
+    SDL_LockMutex(cache->lock);
+    cache->copies = 0;
+    SDL_UnlockMutex(cache->lock);
 }
 
-void NapysDestroyFontCache(NapysFontCache *cache)
+bool NapysResetContextStats(NapysContext *ctx)
 {
-    if (cache)
+    if (!ctx)
     {
-        for (int i = 0; i < NAPYS_MAX_FONT_SIZE; i++)
-        {
-            if (cache->sizes[i] && cache->sizes[i] != cache->base)
-            {
-                TTF_CloseFont(cache->sizes[i]);
-            }
-        }
-        SDL_free(cache);
+        return NapysSetError("Invalid context");
     }
+
+    SDL_LockSpinlock(&ctx->stats_lock);
+    SDL_zero(ctx->stats);
+    SDL_UnlockSpinlock(&ctx->stats_lock);
+
+    NapysIterateHashmap(ctx->fonts, NapysResetFontCopiesCallback, NULL);
+
+    return true;
 }
 
 void NapysDestroyContext(NapysContext *ctx)
@@ -102,6 +125,7 @@ void NapysDestroyContext(NapysContext *ctx)
     {
         if (ctx->registry != NULL)
         {
+            NapysIterateHashmap(ctx->registry, NapysFreeRegistryEntryCallback, NULL);
             NapysDestroyHashmap(ctx->registry);
         }
 
@@ -111,6 +135,9 @@ void NapysDestroyContext(NapysContext *ctx)
             NapysDestroyHashmap(ctx->fonts);
         }
 
+        NapysDestroyTemplateCache(ctx->template_cache);
+        SDL_DestroyMutex(ctx->lock);
+
         SDL_free(ctx);
     }
 }
@@ -180,13 +207,13 @@ bool NapysRegisterFont(NapysContext *ctx, TTF_Font *font, const char *name)
         return NapysSetError("Cannot determine font name");
     }
 
-    if (NapysHashmapGetPointer(ctx->registry, font_name) != NULL)
+    if (NapysHashmapGetPointer(ctx->fonts, font_name) != NULL)
     {
         SDL_free(font_name);
         return NapysSetError("Font already registered");
     }
 
-    NapysFontCache *cache = NapysCreateFontCache(font);
+    NapysFontCache *cache = NapysCreateFontCache(font, &ctx->font_budget);
 
     if (!cache)
     {
@@ -194,7 +221,18 @@ bool NapysRegisterFont(NapysContext *ctx, TTF_Font *font, const char *name)
         return false;
     }
 
-    NapysHashmapStorePointer(ctx->fonts, font_name, cache);
+    bool inserted;
+    NapysFontCache **slot = (NapysFontCache **)NapysHashmapInsert(ctx->fonts, font_name, &inserted);
+
+    if (!slot)
+    {
+        NapysDestroyFontCache(cache);
+        SDL_free(font_name);
+        return NapysSetError("Failed to allocate memory for font");
+    }
+
+    *slot = cache;
+    NapysBumpContextGeneration(ctx);
 
     if (!ctx->default_font_cache)
     {
@@ -206,6 +244,30 @@ bool NapysRegisterFont(NapysContext *ctx, TTF_Font *font, const char *name)
     return true;
 }
 
+// Get the registry entry of the key to fill, releasing the previous value of the key if it was registered before
+static NapysRegistryEntry *NapysPrepareRegistryEntry(NapysContext *ctx, const char *key)
+{
+    bool inserted;
+    NapysRegistryEntry *entry = (NapysRegistryEntry *)NapysHashmapInsert(ctx->registry, key, &inserted);
+
+    if (!entry)
+    {
+        NapysSetError("Failed to allocate memory for registry entry");
+        return NULL;
+    }
+
+    if (!inserted && entry->str)
+    {
+        // Layouts may still point to the released string
+        SDL_free(entry->str);
+        ctx->strings_generation++;
+    }
+
+    SDL_zerop(entry);
+
+    return entry;
+}
+
 bool NapysRegisterString(NapysContext *ctx, const char *key, const char *value)
 {
     if (!ctx || !key || !value)
@@ -213,16 +275,22 @@ bool NapysRegisterString(NapysContext *ctx, const char *key, const char *value)
         return NapysSetError("Invalid context, key, or value");
     }
 
-    NapysRegistryEntry *entry = SDL_malloc(sizeof(NapysRegistryEntry));
+    NapysRegistryEntry *entry = NapysPrepareRegistryEntry(ctx, key);
     if (!entry)
     {
-        return NapysSetError("Failed to allocate memory for registry entry");
+        return false;
     }
 
+    // Lists compiled against the previous value must be compiled again even if this fails
+    NapysBumpContextGeneration(ctx);
+
     entry->str = SDL_strdup(value);
-    entry->type = NAPYS_REGISTRY_ENTRY_STRING;
+    if (!entry->str)
+    {
+        return NapysSetError("Failed to allocate memory for registry string");
+    }
 
-    NapysHashmapStorePointer(ctx->registry, key, entry);
+    entry->type = NAPYS_REGISTRY_ENTRY_STRING;
 
     return true;
 }
@@ -234,38 +302,37 @@ bool NapysRegisterColor(NapysContext *ctx, const char *key, SDL_Color color)
         return NapysSetError("Invalid context or key");
     }
 
-    NapysRegistryEntry *entry = SDL_malloc(sizeof(NapysRegistryEntry));
+    NapysRegistryEntry *entry = NapysPrepareRegistryEntry(ctx, key);
     if (!entry)
     {
-        return NapysSetError("Failed to allocate memory for registry entry");
+        return false;
     }
 
     entry->color = color;
     entry->type = NAPYS_REGISTRY_ENTRY_COLOR;
 
-    NapysHashmapStorePointer(ctx->registry, key, entry);
+    NapysBumpContextGeneration(ctx);
 
     return true;
 }
 
-bool NapysRegisterSize(NapysContext *ctx, const char *key, int pt)
+bool NapysRegisterSize(NapysContext *ctx, const char *key, float pt)
 {
-    if (!ctx || !key || pt < 0)
+    if (!ctx || !key || pt <= 0)
     {
         return NapysSetError("Invalid context, key, or point size");
     }
 
-    NapysRegistryEntry *entry = SDL_malloc(sizeof(NapysRegistryEntry));
+    NapysRegistryEntry *entry = NapysPrepareRegistryEntry(ctx, key);
     if (!entry)
     {
-        return NapysSetError("Failed to allocate memory for registry entry");
+        return false;
     }
 
     entry->type = NAPYS_REGISTRY_ENTRY_SIZE;
-    entry->str = SDL_strdup(key);
     entry->ptsize = pt;
 
-    NapysHashmapStorePointer(ctx->registry, key, entry);
+    NapysBumpContextGeneration(ctx);
 
     return true;
 }
@@ -277,17 +344,36 @@ bool NapysRegisterImage(NapysContext *ctx, const char *key, void *img)
         return NapysSetError("Invalid context, key, or image");
     }
 
-    NapysRegistryEntry *entry = SDL_malloc(sizeof(NapysRegistryEntry));
+    float img_width, img_height;
+
+    if (!SDL_GetTextureSize((SDL_Texture *)img, &img_width, &img_height))
+    {
+        return NapysSetError("Failed to get image size");
+    }
+
+    return NapysRegisterImageWithSize(ctx, key, img, img_width, img_height);
+}
+
+bool NapysRegisterImageWithSize(NapysContext *ctx, const char *key, void *img, float width, float height)
+{
+    if (!ctx || !key || width < 0 || height < 0)
+    {
+        return NapysSetError("Invalid context, key, or image size");
+    }
+
+    NapysRegistryEntry *entry = NapysPrepareRegistryEntry(ctx, key);
     if (!entry)
     {
-        return NapysSetError("Failed to allocate memory for registry entry");
+        return false;
     }
 
     entry->type = NAPYS_REGISTRY_ENTRY_IMAGE;
-    entry->str = NULL;
     entry->img = img;
+    entry->img_width = width;
+    entry->img_height = height;
 
-    NapysHashmapStorePointer(ctx->registry, key, entry);
+    NapysBumpContextGeneration(ctx);
+    entry->img_generation = ctx->generation;
 
     return true;
 }
\ No newline at end of file
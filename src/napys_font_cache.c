@@ -0,0 +1,347 @@
+#include <napys.h>
+#include "napys_internal.h"
+
+// Rough cost of a FreeType face and SDL_ttf font structures
+#define NAPYS_FONT_BASE_BYTES (32 * 1024)
+
+// Number of glyphs assumed to end up in the SDL_ttf glyph cache of a font
+#define NAPYS_FONT_CACHED_GLYPHS 128
+
+static size_t NapysEstimateFontBytes(float ptsize)
+{
+    // Each cached glyph is roughly a ptsize x ptsize 8-bit bitmap
+    const size_t glyph_bytes = (size_t)(ptsize * ptsize);
+
+    return NAPYS_FONT_BASE_BYTES + NAPYS_FONT_CACHED_GLYPHS * glyph_bytes;
+}
+
+static NapysFontSize *NapysAddFontSize(NapysFontCache *cache, TTF_Font *font, float ptsize)
+{
+    if (cache->sizes_count >= cache->sizes_capacity)
+    {
+        int new_capacity = cache->sizes_capacity == 0 ? 4 : cache->sizes_capacity * 2;
+        NapysFontSize *new_sizes = SDL_realloc(cache->sizes, new_capacity * sizeof(NapysFontSize));
+
+        if (!new_sizes)
+        {
+            NapysSetError("Failed to allocate memory for font sizes");
+            return NULL;
+        }
+
+        cache->sizes = new_sizes;
+        cache->sizes_capacity = new_capacity;
+    }
+
+    NapysFontSize *size = &cache->sizes[cache->sizes_count++];
+
+    size->font = font;
+    size->ptsize = ptsize;
+    size->approx_bytes = NapysEstimateFontBytes(ptsize);
+    size->last_used = ++cache->tick;
+    size->refcount = 0;
+
+    cache->approx_bytes += size->approx_bytes;
+
+    return size;
+}
+
+static NapysFontSize *NapysFindFontSize(NapysFontCache *cache, TTF_Font *font)
+{
+    for (int i = 0; i < cache->sizes_count; i++)
+    {
+        if (cache->sizes[i].font == font)
+        {
+            return &cache->sizes[i];
+        }
+    }
+
+    return NULL;
+}
+
+NapysFontCache *NapysCreateFontCache(TTF_Font *fnt, const NapysFontCacheBudget *budget)
+{
+    NapysFontCache *cache = SDL_calloc(1, sizeof(NapysFontCache));
+
+    if (!cache)
+    {
+        NapysSetError("Failed to allocate memory for font cache");
+        return NULL;
+    }
+
+    cache->base = fnt;
+    cache->budget = budget;
+    cache->lock = SDL_CreateMutex();
+
+    if (!cache->lock)
+    {
+        NapysSetError("Failed to create font cache lock");
+        SDL_free(cache);
+        return NULL;
+    }
+
+    NapysFontSize *base_size = NapysAddFontSize(cache, fnt, TTF_GetFontSize(fnt));
+
+    if (!base_size)
+    {
+        SDL_DestroyMutex(cache->lock);
+        SDL_free(cache);
+        return NULL;
+    }
+
+    // The base font belongs to the user and is never closed by the cache
+    base_size->refcount = 1;
+
+    return cache;
+}
+
+static bool NapysFontCacheOverBudget(const NapysFontCache *cache)
+{
+    const NapysFontCacheBudget *budget = cache->budget;
+
+    if (!budget)
+    {
+        return false;
+    }
+
+    return (budget->max_sizes > 0 && cache->sizes_count > budget->max_sizes) ||
+           (budget->max_bytes > 0 && cache->approx_bytes > budget->max_bytes);
+}
+
+void NapysLockFontCache(NapysFontCache *cache)
+{
+    if (cache)
+    {
+        SDL_LockMutex(cache->lock);
+    }
+}
+
+void NapysUnlockFontCache(NapysFontCache *cache)
+{
+    if (cache)
+    {
+        SDL_UnlockMutex(cache->lock);
+    }
+}
+
+void NapysTrimFontCache(NapysFontCache *cache, TTF_Font *keep)
+{
+    if (!cache)
+    {
+        return;
+    }
+
+    SDL_LockMutex(cache->lock);
+
+    while (NapysFontCacheOverBudget(cache))
+    {
+        int lru_index = -1;
+
+        for (int i = 0; i < cache->sizes_count; i++)
+        {
+            const NapysFontSize *size = &cache->sizes[i];
+
+            if (size->refcount > 0 || size->font == keep)
+            {
+                continue;
+            }
+
+            if (lru_index < 0 || size->last_used < cache->sizes[lru_index].last_used)
+            {
+                lru_index = i;
+            }
+        }
+
+        // Everything left is in use
+        if (lru_index < 0)
+        {
+            break;
+        }
+
+        NapysFontSize *evicted = &cache->sizes[lru_index];
+
+        TTF_CloseFont(evicted->font);
+        cache->approx_bytes -= evicted->approx_bytes;
+
+        *evicted = cache->sizes[--cache->sizes_count];
+    }
+
+    SDL_UnlockMutex(cache->lock);
+}
+
+TTF_Font *NapysQueryFontCache(NapysFontCache *cache, float ptsize)
+{
+    if (!cache || ptsize <= 0)
+    {
+        return NULL;
+    }
+
+    SDL_LockMutex(cache->lock);
+
+    // If the requested size is already cached, return it
+    for (int i = 0; i < cache->sizes_count; i++)
+    {
+        NapysFontSize *size = &cache->sizes[i];
+
+        if (size->ptsize == ptsize)
+        {
+            size->last_used = ++cache->tick;
+
+            SDL_UnlockMutex(cache->lock);
+            return size->font;
+        }
+    }
+
+    // Creating the size under the lock makes sure concurrent queries for it create only one copy
+    NAPYS_PROFILE_BEGIN("TTF_CopyFont", cache);
+    TTF_Font *new_font = TTF_CopyFont(cache->base);
+    NAPYS_PROFILE_END("TTF_CopyFont", cache);
+
+    if (!new_font)
+    {
+        SDL_UnlockMutex(cache->lock);
+        NapysSetError("Failed to copy font");
+        return NULL;
+    }
+
+    cache->copies++;
+
+    if (!TTF_SetFontSize(new_font, ptsize))
+    {
+        TTF_CloseFont(new_font);
+        SDL_UnlockMutex(cache->lock);
+        NapysSetError("Failed to set font size");
+        return NULL;
+    }
+
+    if (!NapysAddFontSize(cache, new_font, ptsize))
+    {
+        TTF_CloseFont(new_font);
+        SDL_UnlockMutex(cache->lock);
+        return NULL;
+    }
+
+    NapysTrimFontCache(cache, new_font);
+
+    SDL_UnlockMutex(cache->lock);
+
+    return new_font;
+}
+
+TTF_Font *NapysAcquireCachedFont(NapysFontCache *cache, float ptsize)
+{
+    if (!cache)
+    {
+        return NULL;
+    }
+
+    // Query and retain at once, so another thread cannot evict the font in between
+    SDL_LockMutex(cache->lock);
+
+    TTF_Font *font = NapysQueryFontCache(cache, ptsize);
+    NapysRetainCachedFont(cache, font);
+
+    SDL_UnlockMutex(cache->lock);
+
+    return font;
+}
+
+void NapysRetainCachedFont(NapysFontCache *cache, TTF_Font *font)
+{
+    if (!cache || !font)
+    {
+        return;
+    }
+
+    SDL_LockMutex(cache->lock);
+
+    NapysFontSize *size = NapysFindFontSize(cache, font);
+
+    if (size)
+    {
+        size->refcount++;
+    }
+
+    SDL_UnlockMutex(cache->lock);
+}
+
+void NapysReleaseCachedFont(NapysFontCache *cache, TTF_Font *font)
+{
+    if (!cache || !font)
+    {
+        return;
+    }
+
+    SDL_LockMutex(cache->lock);
+
+    NapysFontSize *size = NapysFindFontSize(cache, font);
+
+    if (size && size->refcount > 0)
+    {
+        size->refcount--;
+    }
+
+    SDL_UnlockMutex(cache->lock);
+}
+
+void NapysDestroyFontCache(NapysFontCache *cache)
+{
+    if (cache)
+    {
+        for (int i = 0; i < cache->sizes_count; i++)
+        {
+            if (cache->sizes[i].font != cache->base)
+            {
+                TTF_CloseFont(cache->sizes[i].font);
+            }
+        }
+        SDL_DestroyMutex(cache->lock);
+        SDL_free(cache->sizes);
+        SDL_free(cache);
+    }
+}
+
+static void NapysTrimFontCacheCallback(const char *key, void *value, void *userdata)
+{
+    NapysTrimFontCache(*(NapysFontCache **)value, NULL);
+}
+
+bool NapysSetFontCacheBudget(NapysContext *ctx, int max_sizes, size_t max_bytes)
+{
+    if (!ctx || max_sizes < 0)
+    {
+        return NapysSetError("Invalid context or font cache budget");
+    }
+
+    ctx->font_budget.max_sizes = max_sizes;
+    ctx->font_budget.max_bytes = max_bytes;
+
+    NapysIterateHashmap(ctx->fonts, NapysTrimFontCacheCallback, NULL);
+
+    return true;
+}
+
+static void NapysSumFontCacheStatsCallback(const char *key, void *value, void *userdata)
+{
+    NapysFontCache *cache = *(NapysFontCache **)value;
+    NapysFontCacheStats *stats = (NapysFontCacheStats *)userdata;
+
+    SDL_LockMutex(cache->lock);
+    stats->resident_sizes += cache->sizes_count;
+    stats->approx_bytes += cache->approx_bytes;
+    SDL_UnlockMutex(cache->lock);
+}
+
+bool NapysGetFontCacheStats(NapysContext *ctx, NapysFontCacheStats *stats)
+{
+    if (!ctx || !stats)
+    {
+        return NapysSetError("Invalid context or stats");
+    }
+
+    stats->resident_sizes = 0;
+    stats->approx_bytes = 0;
+
+    NapysIterateHashmap(ctx->fonts, NapysSumFontCacheStatsCallback, stats);
+
+    return true;
+}
@@ -0,0 +1,483 @@
+#include <napys.h>
+#include "napys_internal.h"
+
+// Empty pixels kept around every packed glyph, so linear filtering never samples a neighbour
+#define NAPYS_GLYPH_ATLAS_PADDING 1
+
+struct NapysGlyphAtlas
+{
+    SDL_Renderer *renderer;
+
+    SDL_Texture **pages;
+    int pages_count;
+    int pages_capacity;
+
+    Uint32 epoch; // Number of clears, labels executed before the last clear use removed glyphs
+
+    // Shelf packing state of the last page
+    int shelf_x;
+    int shelf_y;
+    int shelf_height;
+
+    NapysAtlasGlyph *glyphs;
+    int glyphs_count;
+    int glyphs_capacity;
+
+    // Open addressing index into glyphs, storing glyph index + 1 (0 is an empty slot)
+    int *slots;
+    Uint32 slots_mask;
+
+    // Scratch buffers for merging the geometry of batched labels
+    SDL_Vertex *batch_vertices;
+    int batch_vertices_capacity;
+    int *batch_indices;
+    int batch_indices_capacity;
+};
+
+static Uint32 NapysHashGlyphKey(const void *owner, float ptsize, Uint32 codepoint)
+{
+    Uint32 size_bits;
+    SDL_memcpy(&size_bits, &ptsize, sizeof(size_bits));
+
+    Uint64 owner_bits = (Uint64)(uintptr_t)owner;
+
+    Uint32 h = (Uint32)owner_bits ^ (Uint32)(owner_bits >> 32);
+    h ^= size_bits * 0x85ebca6bu;
+    h ^= codepoint * 0xc2b2ae35u;
+
+    // murmur3 finalizer
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+
+    return h;
+}
+
+static bool NapysRebuildGlyphSlots(NapysGlyphAtlas *atlas, Uint32 slots_count)
+{
+    int *slots = SDL_calloc(slots_count, sizeof(int));
+
+    if (!slots)
+    {
+        return NapysSetError("Failed to allocate memory for glyph atlas index");
+    }
+
+    const Uint32 mask = slots_count - 1;
+
+    for (int i = 0; i < atlas->glyphs_count; i++)
+    {
+        const NapysAtlasGlyph *glyph = &atlas->glyphs[i];
+        Uint32 slot = NapysHashGlyphKey(glyph->owner, glyph->ptsize, glyph->codepoint) & mask;
+
+        while (slots[slot] != 0)
+        {
+            slot = (slot + 1) & mask;
+        }
+
+        slots[slot] = i + 1;
+    }
+
+    SDL_free(atlas->slots);
+    atlas->slots = slots;
+    atlas->slots_mask = mask;
+
+    return true;
+}
+
+NapysGlyphAtlas *NapysCreateGlyphAtlas(SDL_Renderer *renderer)
+{
+    NapysGlyphAtlas *atlas = SDL_calloc(1, sizeof(NapysGlyphAtlas));
+
+    if (!atlas)
+    {
+        NapysSetError("Failed to allocate memory for glyph atlas");
+        return NULL;
+    }
+
+    atlas->renderer = renderer;
+
+    if (!NapysRebuildGlyphSlots(atlas, 256))
+    {
+        SDL_free(atlas);
+        return NULL;
+    }
+
+    return atlas;
+}
+
+void NapysDestroyGlyphAtlas(NapysGlyphAtlas *atlas)
+{
+    if (atlas)
+    {
+        for (int i = 0; i < atlas->pages_count; i++)
+        {
+            SDL_DestroyTexture(atlas->pages[i]);
+        }
+
+        SDL_free(atlas->pages);
+        SDL_free(atlas->glyphs);
+        SDL_free(atlas->slots);
+        SDL_free(atlas->batch_vertices);
+        SDL_free(atlas->batch_indices);
+        SDL_free(atlas);
+    }
+}
+
+bool NapysClearGlyphAtlas(NapysGlyphAtlas *atlas)
+{
+    if (!atlas)
+    {
+        return NapysSetError("Invalid glyph atlas");
+    }
+
+    for (int i = 0; i < atlas->pages_count; i++)
+    {
+        SDL_DestroyTexture(atlas->pages[i]);
+    }
+
+    atlas->pages_count = 0;
+    atlas->glyphs_count = 0;
+    SDL_memset(atlas->slots, 0, (atlas->slots_mask + 1) * sizeof(int));
+
+    atlas->epoch++;
+
+    return true;
+}
+
+Uint32 NapysGetAtlasEpoch(NapysGlyphAtlas *atlas)
+{
+    return atlas->epoch;
+}
+
+SDL_Texture *NapysGetAtlasPage(NapysGlyphAtlas *atlas, int page)
+{
+    if (!atlas || page < 0 || page >= atlas->pages_count)
+    {
+        return NULL;
+    }
+
+    return atlas->pages[page];
+}
+
+int NapysGetGlyphAtlasPageCount(NapysGlyphAtlas *atlas)
+{
+    return atlas ? atlas->pages_count : 0;
+}
+
+SDL_Renderer *NapysGetAtlasRenderer(NapysGlyphAtlas *atlas)
+{
+    return atlas ? atlas->renderer : NULL;
+}
+
+bool NapysBuildQuadIndices(int **indices, int *indices_capacity, int quad_count)
+{
+    const int indices_count = quad_count * 6;
+
+    if (indices_count <= *indices_capacity)
+    {
+        return true;
+    }
+
+    int *new_indices = SDL_realloc(*indices, indices_count * sizeof(int));
+
+    if (!new_indices)
+    {
+        return NapysSetError("Failed to allocate memory for atlas indices");
+    }
+
+    // Indices are relative to the first vertex of a draw call, so one pattern serves all of them
+    for (int q = *indices_capacity / 6; q < quad_count; q++)
+    {
+        int *quad = &new_indices[q * 6];
+        const int base = q * 4;
+
+        quad[0] = base + 0;
+        quad[1] = base + 1;
+        quad[2] = base + 2;
+        quad[3] = base + 2;
+        quad[4] = base + 1;
+        quad[5] = base + 3;
+    }
+
+    *indices = new_indices;
+    *indices_capacity = indices_count;
+
+    return true;
+}
+
+SDL_Vertex *NapysReserveAtlasBatchVertices(NapysGlyphAtlas *atlas, int vertices_count)
+{
+    if (vertices_count > atlas->batch_vertices_capacity)
+    {
+        SDL_Vertex *new_vertices = SDL_realloc(atlas->batch_vertices, vertices_count * sizeof(SDL_Vertex));
+
+        if (!new_vertices)
+        {
+            NapysSetError("Failed to allocate memory for atlas batch vertices");
+            return NULL;
+        }
+
+        atlas->batch_vertices = new_vertices;
+        atlas->batch_vertices_capacity = vertices_count;
+    }
+
+    return atlas->batch_vertices;
+}
+
+const int *NapysReserveAtlasBatchIndices(NapysGlyphAtlas *atlas, int quad_count)
+{
+    if (!NapysBuildQuadIndices(&atlas->batch_indices, &atlas->batch_indices_capacity, quad_count))
+    {
+        return NULL;
+    }
+
+    return atlas->batch_indices;
+}
+
+static bool NapysAddAtlasPage(NapysGlyphAtlas *atlas)
+{
+    if (atlas->pages_count >= atlas->pages_capacity)
+    {
+        int new_capacity = atlas->pages_capacity == 0 ? 2 : atlas->pages_capacity * 2;
+        SDL_Texture **new_pages = SDL_realloc(atlas->pages, new_capacity * sizeof(SDL_Texture *));
+
+        if (!new_pages)
+        {
+            return NapysSetError("Failed to allocate memory for glyph atlas pages");
+        }
+
+        atlas->pages = new_pages;
+        atlas->pages_capacity = new_capacity;
+    }
+
+    SDL_Texture *page = SDL_CreateTexture(atlas->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                          NAPYS_GLYPH_ATLAS_PAGE_SIZE, NAPYS_GLYPH_ATLAS_PAGE_SIZE);
+
+    if (!page)
+    {
+        return NapysSetError("Failed to create glyph atlas page texture");
+    }
+
+    SDL_SetTextureBlendMode(page, SDL_BLENDMODE_BLEND);
+
+    // Contents of new render targets are undefined, so clear the page to transparent
+    SDL_Texture *previous_target = SDL_GetRenderTarget(atlas->renderer);
+    Uint8 r, g, b, a;
+    SDL_GetRenderDrawColor(atlas->renderer, &r, &g, &b, &a);
+
+    SDL_SetRenderTarget(atlas->renderer, page);
+    SDL_SetRenderDrawColor(atlas->renderer, 0, 0, 0, 0);
+    SDL_RenderClear(atlas->renderer);
+
+    SDL_SetRenderDrawColor(atlas->renderer, r, g, b, a);
+    SDL_SetRenderTarget(atlas->renderer, previous_target);
+
+    atlas->pages[atlas->pages_count++] = page;
+
+    atlas->shelf_x = 0;
+    atlas->shelf_y = 0;
+    atlas->shelf_height = 0;
+
+    return true;
+}
+
+// Reserve a w x h rectangle in the last page, starting a new shelf or page when needed
+static bool NapysPackAtlasRect(NapysGlyphAtlas *atlas, int w, int h, int *page, SDL_Rect *rect)
+{
+    const int padded_w = w + NAPYS_GLYPH_ATLAS_PADDING;
+    const int padded_h = h + NAPYS_GLYPH_ATLAS_PADDING;
+
+    if (padded_w > NAPYS_GLYPH_ATLAS_PAGE_SIZE || padded_h > NAPYS_GLYPH_ATLAS_PAGE_SIZE)
+    {
+        return NapysSetError("Glyph or image is too big for the glyph atlas");
+    }
+
+    if (atlas->pages_count > 0 && atlas->shelf_x + padded_w > NAPYS_GLYPH_ATLAS_PAGE_SIZE)
+    {
+        atlas->shelf_x = 0;
+        atlas->shelf_y += atlas->shelf_height;
+        atlas->shelf_height = 0;
+    }
+
+    if (atlas->pages_count == 0 || atlas->shelf_y + padded_h > NAPYS_GLYPH_ATLAS_PAGE_SIZE)
+    {
+        if (!NapysAddAtlasPage(atlas))
+        {
+            return false;
+        }
+    }
+
+    *page = atlas->pages_count - 1;
+    *rect = (SDL_Rect){atlas->shelf_x, atlas->shelf_y, w, h};
+
+    atlas->shelf_x += padded_w;
+
+    if (padded_h > atlas->shelf_height)
+    {
+        atlas->shelf_height = padded_h;
+    }
+
+    return true;
+}
+
+static NapysAtlasGlyph *NapysFindAtlasGlyph(NapysGlyphAtlas *atlas, const void *owner, float ptsize, Uint32 codepoint)
+{
+    Uint32 slot = NapysHashGlyphKey(owner, ptsize, codepoint) & atlas->slots_mask;
+
+    while (atlas->slots[slot] != 0)
+    {
+        NapysAtlasGlyph *glyph = &atlas->glyphs[atlas->slots[slot] - 1];
+
+        if (glyph->owner == owner && glyph->ptsize == ptsize && glyph->codepoint == codepoint)
+        {
+            return glyph;
+        }
+
+        slot = (slot + 1) & atlas->slots_mask;
+    }
+
+    return NULL;
+}
+
+static NapysAtlasGlyph *NapysInsertAtlasGlyph(NapysGlyphAtlas *atlas, const NapysAtlasGlyph *glyph)
+{
+    // Keep the index at most half full
+    if ((Uint32)(atlas->glyphs_count + 1) * 2 > atlas->slots_mask + 1)
+    {
+        if (!NapysRebuildGlyphSlots(atlas, (atlas->slots_mask + 1) * 2))
+        {
+            return NULL;
+        }
+    }
+
+    if (atlas->glyphs_count >= atlas->glyphs_capacity)
+    {
+        int new_capacity = atlas->glyphs_capacity == 0 ? 128 : atlas->glyphs_capacity * 2;
+        NapysAtlasGlyph *new_glyphs = SDL_realloc(atlas->glyphs, new_capacity * sizeof(NapysAtlasGlyph));
+
+        if (!new_glyphs)
+        {
+            NapysSetError("Failed to allocate memory for glyph atlas");
+            return NULL;
+        }
+
+        atlas->glyphs = new_glyphs;
+        atlas->glyphs_capacity = new_capacity;
+    }
+
+    const int index = atlas->glyphs_count++;
+    atlas->glyphs[index] = *glyph;
+
+    Uint32 slot = NapysHashGlyphKey(glyph->owner, glyph->ptsize, glyph->codepoint) & atlas->slots_mask;
+
+    while (atlas->slots[slot] != 0)
+    {
+        slot = (slot + 1) & atlas->slots_mask;
+    }
+
+    atlas->slots[slot] = index + 1;
+
+    return &atlas->glyphs[index];
+}
+
+const NapysAtlasGlyph *NapysGetAtlasGlyph(NapysGlyphAtlas *atlas, NapysFontCache *cache, TTF_Font *font, float ptsize, Uint32 codepoint)
+{
+    NapysAtlasGlyph *existing = NapysFindAtlasGlyph(atlas, cache, ptsize, codepoint);
+
+    if (existing)
+    {
+        return existing;
+    }
+
+    if (!font)
+    {
+        return NULL;
+    }
+
+    NapysAtlasGlyph glyph = {0};
+    glyph.owner = cache;
+    glyph.ptsize = ptsize;
+    glyph.codepoint = codepoint;
+    glyph.page = -1;
+
+    int minx = 0;
+
+    // Glyphs are rendered white and tinted by the vertex colors when drawn
+    NapysLockFontCache(cache);
+    TTF_GetGlyphMetrics(font, codepoint, &minx, NULL, NULL, NULL, &glyph.advance);
+    SDL_Surface *surface = TTF_RenderGlyph_Blended(font, codepoint, (SDL_Color){255, 255, 255, 255});
+    NapysUnlockFontCache(cache);
+
+    if (surface && surface->w > 0 && surface->h > 0)
+    {
+        SDL_Surface *converted = surface->format == SDL_PIXELFORMAT_ARGB8888 ? surface : SDL_ConvertSurface(surface, SDL_PIXELFORMAT_ARGB8888);
+
+        if (converted && NapysPackAtlasRect(atlas, converted->w, converted->h, &glyph.page, &glyph.rect))
+        {
+            SDL_UpdateTexture(atlas->pages[glyph.page], &glyph.rect, converted->pixels, converted->pitch);
+
+            // The rendered glyph cell starts at the leftmost pixel, which may be left of the pen for some glyphs
+            glyph.offset_x = minx < 0 ? minx : 0;
+        }
+        else
+        {
+            glyph.page = -1;
+        }
+
+        if (converted && converted != surface)
+        {
+            SDL_DestroySurface(converted);
+        }
+    }
+
+    SDL_DestroySurface(surface);
+
+    return NapysInsertAtlasGlyph(atlas, &glyph);
+}
+
+const NapysAtlasGlyph *NapysGetAtlasImage(NapysGlyphAtlas *atlas, SDL_Texture *img, Uint32 img_generation)
+{
+    // Every registration of an image is copied again, so reused or updated textures are never drawn stale
+    NapysAtlasGlyph *existing = NapysFindAtlasGlyph(atlas, img, 0, img_generation);
+
+    if (existing)
+    {
+        return existing;
+    }
+
+    float img_width, img_height;
+
+    if (!SDL_GetTextureSize(img, &img_width, &img_height))
+    {
+        NapysSetError("Failed to get image size");
+        return NULL;
+    }
+
+    NapysAtlasGlyph glyph = {0};
+    glyph.owner = img;
+    glyph.codepoint = img_generation;
+    glyph.page = -1;
+    glyph.advance = (int)img_width;
+
+    if (!NapysPackAtlasRect(atlas, (int)img_width, (int)img_height, &glyph.page, &glyph.rect))
+    {
+        return NULL;
+    }
+
+    // Copy the image into the atlas page as is, without blending with the cleared page
+    SDL_Texture *previous_target = SDL_GetRenderTarget(atlas->renderer);
+    SDL_BlendMode previous_blend_mode = SDL_BLENDMODE_NONE;
+    SDL_GetTextureBlendMode(img, &previous_blend_mode);
+
+    SDL_FRect dst = {(float)glyph.rect.x, (float)glyph.rect.y, (float)glyph.rect.w, (float)glyph.rect.h};
+
+    SDL_SetRenderTarget(atlas->renderer, atlas->pages[glyph.page]);
+    SDL_SetTextureBlendMode(img, SDL_BLENDMODE_NONE);
+    SDL_RenderTexture(atlas->renderer, img, NULL, &dst);
+    SDL_SetTextureBlendMode(img, previous_blend_mode);
+    SDL_SetRenderTarget(atlas->renderer, previous_target);
+
+    return NapysInsertAtlasGlyph(atlas, &glyph);
+}
@@ -5,21 +5,106 @@
 
 bool NapysSetError(const char *message);
 
+#ifdef NAPYS_PROFILING
+void NapysBeginProfilingZone(const char *name, const void *label);
+void NapysEndProfilingZone(const char *name, const void *label);
+
+#define NAPYS_PROFILE_BEGIN(name, label) NapysBeginProfilingZone(name, label)
+#define NAPYS_PROFILE_END(name, label) NapysEndProfilingZone(name, label)
+#else
+#define NAPYS_PROFILE_BEGIN(name, label) ((void)0)
+#define NAPYS_PROFILE_END(name, label) ((void)0)
+#endif
+
+// Open-addressing hash map with string keys and values of a fixed size stored inline.
+// Reads do not lock, so a map may be read by any number of threads as long as nothing is inserted meanwhile.
+// Inserting may move the values, so pointers to them are valid only until the next insertion.
 typedef struct NapysHashmap
 {
-    SDL_PropertiesID data;
+    Uint32 *hashes;  // Hash of every slot, 0 for empty slots
+    char **keys;     // Owned copy of the key of every slot
+    Uint8 *values;   // value_size bytes per slot
+    size_t value_size;
+    Uint32 capacity; // Number of slots, a power of two
+    Uint32 count;    // Number of used slots
 } NapysHashmap;
 
 typedef void (*NapysHashmapCallback)(const char *key, void *value, void *userdata);
 
-NapysHashmap *NapysCreateHashmap();
+NapysHashmap *NapysCreateHashmap(size_t value_size);
+void *NapysHashmapInsert(NapysHashmap *map, const char *key, bool *inserted);
+void *NapysHashmapFind(const NapysHashmap *map, const char *key);
 void NapysHashmapStorePointer(NapysHashmap *map, const char *key, void *value);
-void *NapysHashmapGetPointer(NapysHashmap *map, const char *key);
-void *NapysIterateHashmap(NapysHashmap *map, NapysHashmapCallback callback, void *userdata);
+void *NapysHashmapGetPointer(const NapysHashmap *map, const char *key);
+void NapysIterateHashmap(NapysHashmap *map, NapysHashmapCallback callback, void *userdata);
 void NapysDestroyHashmap(NapysHashmap *map);
 
-NapysFontCache *NapysCreateFontCache(TTF_Font *fnt);
-TTF_Font *NapysQueryFontCache(NapysFontCache *cache, int ptsize);
+#define NAPYS_ARENA_BLOCK_SIZE 1024
+
+typedef struct NapysArenaBlock
+{
+    struct NapysArenaBlock *next;
+    size_t capacity;
+    size_t used;
+    char data[];
+} NapysArenaBlock;
+
+typedef struct NapysArena
+{
+    NapysArenaBlock *first;
+    NapysArenaBlock *current;
+} NapysArena;
+
+NapysArena *NapysCreateArena();
+char *NapysArenaAlloc(NapysArena *arena, size_t size);
+char *NapysArenaStrndup(NapysArena *arena, const char *str, size_t length);
+void NapysResetArena(NapysArena *arena);
+void NapysDestroyArena(NapysArena *arena);
+
+bool NapysAddCommandWithLength(NapysCommandList *list, NapysCommandType type, const char *data, size_t length);
+bool NapysPushCommand(NapysCommandList *list, NapysCommandType type, char *data);
+bool NapysEnsureCommandListCompiled(NapysContext *ctx, NapysCommandList *list);
+Uint32 NapysNextListRevision();
+const NapysContext *NapysGetCommandPackContext(const NapysCommandPack *pack);
+
+const char *NapysFindDelimiter(const char *cursor, const char *end, char first, char second);
+const char *NapysFindDelimiterScalar(const char *cursor, const char *end, char first, char second);
+const char *NapysFindString(const char *cursor, const char *end, const char *needle, size_t needle_length);
+
+NapysFontCache *NapysCreateFontCache(TTF_Font *fnt, const NapysFontCacheBudget *budget);
+TTF_Font *NapysQueryFontCache(NapysFontCache *cache, float ptsize);
+TTF_Font *NapysAcquireCachedFont(NapysFontCache *cache, float ptsize);
+void NapysRetainCachedFont(NapysFontCache *cache, TTF_Font *font);
+void NapysReleaseCachedFont(NapysFontCache *cache, TTF_Font *font);
+void NapysTrimFontCache(NapysFontCache *cache, TTF_Font *keep);
 void NapysDestroyFontCache(NapysFontCache *cache);
+void NapysLockFontCache(NapysFontCache *cache);
+void NapysUnlockFontCache(NapysFontCache *cache);
+
+void NapysBumpContextGeneration(NapysContext *ctx);
+void NapysAddContextStats(NapysContext *ctx, const NapysContextStats *delta);
+
+void NapysDestroyTemplateCache(NapysTemplateCache *cache);
+
+typedef struct
+{
+    const void *owner; // Font cache for glyphs, texture for images
+    float ptsize;      // Font size for glyphs, 0 for images
+    Uint32 codepoint;  // Codepoint for glyphs, registration generation for images
+
+    int page;      // Atlas page storing the pixels, -1 if the glyph has no pixels (e.g. space)
+    SDL_Rect rect; // Location of the pixels in the page
+    int offset_x;  // Horizontal offset of the pixels from the pen position
+    int advance;   // Horizontal pen advance after the glyph
+} NapysAtlasGlyph;
+
+const NapysAtlasGlyph *NapysGetAtlasGlyph(NapysGlyphAtlas *atlas, NapysFontCache *cache, TTF_Font *font, float ptsize, Uint32 codepoint);
+const NapysAtlasGlyph *NapysGetAtlasImage(NapysGlyphAtlas *atlas, SDL_Texture *img, Uint32 img_generation);
+SDL_Texture *NapysGetAtlasPage(NapysGlyphAtlas *atlas, int page);
+Uint32 NapysGetAtlasEpoch(NapysGlyphAtlas *atlas);
+SDL_Renderer *NapysGetAtlasRenderer(NapysGlyphAtlas *atlas);
+SDL_Vertex *NapysReserveAtlasBatchVertices(NapysGlyphAtlas *atlas, int vertices_count);
+const int *NapysReserveAtlasBatchIndices(NapysGlyphAtlas *atlas, int quad_count);
+bool NapysBuildQuadIndices(int **indices, int *indices_capacity, int quad_count);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,910 @@
+#include <napys.h>
+#include "napys_internal.h"
+
+static void NapysReleaseLayoutPieces(NapysLayout *layout)
+{
+    for (int i = 0; i < layout->pieces_count; i++)
+    {
+        NapysLayoutPiece *piece = &layout->pieces[i];
+
+        if (piece->type == NAPYS_LAYOUT_RUN_TEXT && piece->font)
+        {
+            NapysReleaseCachedFont(piece->font_cache, piece->font);
+        }
+    }
+
+    layout->pieces_count = 0;
+    layout->pieces_list = NULL;
+}
+
+// Word sizes are kept for words up to this length, longer words are rare and are measured every time
+#define NAPYS_LAYOUT_WORD_KEY_SIZE 128
+
+// Once the cache holds this many more words than the layout has pieces, it is dropped and filled again
+#define NAPYS_LAYOUT_WORD_SIZES_SLACK 1024
+
+typedef struct
+{
+    int width;
+    int advance;
+    int height;
+} NapysWordSize;
+
+static void NapysResetLayoutFont(NapysLayout *layout)
+{
+    layout->current_color = (SDL_Color){255, 255, 255, 255};
+    layout->current_font_size = 12;
+    layout->current_align = -1;
+    layout->current_font_cache = layout->ctx->default_font_cache;
+    layout->current_font = NapysAcquireCachedFont(layout->current_font_cache, layout->current_font_size);
+}
+
+// The current font is kept alive while measuring, as other threads may query other sizes of the same font meanwhile
+static void NapysSetLayoutFont(NapysLayout *layout, NapysFontCache *font_cache, float ptsize)
+{
+    TTF_Font *new_font = NapysAcquireCachedFont(font_cache, ptsize);
+
+    if (new_font)
+    {
+        NapysReleaseCachedFont(layout->current_font_cache, layout->current_font);
+
+        layout->current_font = new_font;
+        layout->current_font_cache = font_cache;
+    }
+}
+
+NapysLayout *NapysCreateLayout(NapysContext *ctx)
+{
+    if (!ctx)
+    {
+        NapysSetError("Invalid context");
+        return NULL;
+    }
+
+    NapysLayout *layout = SDL_calloc(1, sizeof(NapysLayout));
+
+    if (!layout)
+    {
+        NapysSetError("Failed to allocate memory for NapysLayout");
+        return NULL;
+    }
+
+    layout->ctx = ctx;
+
+    return layout;
+}
+
+bool NapysSetLayoutWrapWidth(NapysLayout *layout, int wrap_width)
+{
+    if (!layout || wrap_width < 0)
+    {
+        return NapysSetError("Invalid layout or wrap width");
+    }
+
+    layout->wrap_width = wrap_width;
+
+    return true;
+}
+
+bool NapysSetLayoutAlign(NapysLayout *layout, NapysAlign align)
+{
+    if (!layout || align < NAPYS_ALIGN_LEFT || align > NAPYS_ALIGN_JUSTIFY)
+    {
+        return NapysSetError("Invalid layout or alignment");
+    }
+
+    layout->align = align;
+
+    return true;
+}
+
+void NapysDestroyLayout(NapysLayout *layout)
+{
+    if (layout)
+    {
+        NapysReleaseLayoutPieces(layout);
+        NapysDestroyHashmap(layout->word_sizes);
+
+        SDL_free(layout->pieces);
+        SDL_free(layout->lines);
+        SDL_free(layout->runs);
+        SDL_free(layout);
+    }
+}
+
+static NapysLayoutRun *NapysAddLayoutRun(NapysLayout *layout, NapysLayoutRunType type)
+{
+    if (layout->runs_count >= layout->runs_capacity)
+    {
+        int new_capacity = layout->runs_capacity == 0 ? 16 : layout->runs_capacity * 2;
+        NapysLayoutRun *new_runs = SDL_realloc(layout->runs, new_capacity * sizeof(NapysLayoutRun));
+
+        if (!new_runs)
+        {
+            NapysSetError("Failed to allocate memory for layout runs");
+            return NULL;
+        }
+
+        layout->runs = new_runs;
+        layout->runs_capacity = new_capacity;
+    }
+
+    NapysLayoutRun *run = &layout->runs[layout->runs_count++];
+    SDL_zerop(run);
+    run->type = type;
+
+    return run;
+}
+
+static void NapysUpdateLayoutBounds(NapysLayout *layout, int x, int y, int width, int height)
+{
+    if (x < layout->bounds.x)
+        layout->bounds.x = x;
+    if (y < layout->bounds.y)
+        layout->bounds.y = y;
+
+    const int end_x = x + width;
+    const int end_y = y + height;
+
+    if (end_x > layout->bounds.x + layout->bounds.w)
+    {
+        layout->bounds.w += end_x - (layout->bounds.x + layout->bounds.w);
+    }
+
+    if (y + height > layout->bounds.h + layout->bounds.y)
+    {
+        layout->bounds.h += end_y - (layout->bounds.y + layout->bounds.h);
+    }
+}
+
+static NapysLayoutPiece *NapysAddLayoutPiece(NapysLayout *layout, NapysLayoutRunType type)
+{
+    if (layout->pieces_count >= layout->pieces_capacity)
+    {
+        int new_capacity = layout->pieces_capacity == 0 ? 32 : layout->pieces_capacity * 2;
+        NapysLayoutPiece *new_pieces = SDL_realloc(layout->pieces, new_capacity * sizeof(NapysLayoutPiece));
+
+        if (!new_pieces)
+        {
+            NapysSetError("Failed to allocate memory for layout pieces");
+            return NULL;
+        }
+
+        layout->pieces = new_pieces;
+        layout->pieces_capacity = new_capacity;
+    }
+
+    NapysLayoutPiece *piece = &layout->pieces[layout->pieces_count++];
+    SDL_zerop(piece);
+    piece->type = type;
+    piece->align = layout->current_align;
+
+    if (layout->current_font)
+    {
+        piece->ascent = TTF_GetFontAscent(layout->current_font);
+        piece->descent = TTF_GetFontDescent(layout->current_font);
+    }
+
+    return piece;
+}
+
+static bool NapysAddNewlinePiece(NapysLayout *layout)
+{
+    NapysLayoutPiece *piece = NapysAddLayoutPiece(layout, NAPYS_LAYOUT_RUN_TEXT);
+
+    if (!piece)
+    {
+        return false;
+    }
+
+    piece->flags = NAPYS_LAYOUT_PIECE_NEWLINE;
+
+    return true;
+}
+
+static bool NapysIsLayoutSpace(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+static void NapysMeasureWordWithFont(NapysLayoutPiece *piece, size_t word_length)
+{
+    // Fonts are not thread-safe, so measuring is serialized with other users of the same font cache
+    NapysLockFontCache(piece->font_cache);
+
+    TTF_GetStringSize(piece->font, piece->text, piece->length, &piece->advance, &piece->height);
+
+    // A length of 0 would measure up to the terminator, so whitespace without a word is measured as empty
+    if (word_length == 0)
+    {
+        piece->width = 0;
+    }
+    else if (piece->length > word_length)
+    {
+        TTF_GetStringSize(piece->font, piece->text, word_length, &piece->width, NULL);
+    }
+    else
+    {
+        piece->width = piece->advance;
+    }
+
+    NapysUnlockFontCache(piece->font_cache);
+}
+
+// Words of a list that changed are mostly the same as before, so their sizes are looked up instead of measured again
+static void NapysMeasureWord(NapysLayout *layout, NapysLayoutPiece *piece, size_t word_length)
+{
+    char key[NAPYS_LAYOUT_WORD_KEY_SIZE];
+
+    // The font cache and size identify the font, as the font itself may be evicted and another one opened at its address
+    const int prefix = SDL_snprintf(key, sizeof(key), "%p %g ", (void *)piece->font_cache, piece->ptsize);
+
+    if (prefix < 0 || piece->length >= sizeof(key) - (size_t)prefix)
+    {
+        NapysMeasureWordWithFont(piece, word_length);
+        return;
+    }
+
+    SDL_memcpy(key + prefix, piece->text, piece->length);
+    key[prefix + piece->length] = '\0';
+
+    const NapysWordSize *cached = layout->word_sizes ? NapysHashmapFind(layout->word_sizes, key) : NULL;
+
+    if (cached)
+    {
+        piece->width = cached->width;
+        piece->advance = cached->advance;
+        piece->height = cached->height;
+        return;
+    }
+
+    NapysMeasureWordWithFont(piece, word_length);
+
+    if (!layout->word_sizes)
+    {
+        layout->word_sizes = NapysCreateHashmap(sizeof(NapysWordSize));
+    }
+
+    // The size is only a shortcut, so failing to remember it is not an error
+    bool inserted;
+    NapysWordSize *size = layout->word_sizes ? NapysHashmapInsert(layout->word_sizes, key, &inserted) : NULL;
+
+    if (size)
+    {
+        *size = (NapysWordSize){piece->width, piece->advance, piece->height};
+    }
+}
+
+static bool NapysMeasureText(NapysLayout *layout, const char *text)
+{
+    // Commands added at runtime may have no text
+    if (!layout->current_font || !text)
+    {
+        return true;
+    }
+
+    while (*text)
+    {
+        if (*text == '\n')
+        {
+            if (!NapysAddNewlinePiece(layout))
+            {
+                return false;
+            }
+
+            text++;
+            continue;
+        }
+
+        // A piece is a word followed by the whitespace after it, lines can only be broken between pieces
+        size_t word_length = 0;
+
+        while (text[word_length] && text[word_length] != '\n' && !NapysIsLayoutSpace(text[word_length]))
+        {
+            word_length++;
+        }
+
+        size_t length = word_length;
+
+        while (NapysIsLayoutSpace(text[length]))
+        {
+            length++;
+        }
+
+        NapysLayoutPiece *piece = NapysAddLayoutPiece(layout, NAPYS_LAYOUT_RUN_TEXT);
+
+        if (!piece)
+        {
+            return false;
+        }
+
+        piece->text = text;
+        piece->length = length;
+        piece->font = layout->current_font;
+        piece->font_cache = layout->current_font_cache;
+        piece->ptsize = layout->current_font_size;
+        piece->color = layout->current_color;
+        piece->flags = length > word_length ? NAPYS_LAYOUT_PIECE_BREAK_AFTER : 0;
+
+        NapysMeasureWord(layout, piece, word_length);
+
+        // Pieces keep their fonts alive, so later size changes cannot evict them from the font cache
+        NapysRetainCachedFont(piece->font_cache, piece->font);
+
+        text += length;
+    }
+
+    return true;
+}
+
+static int NapysParseAlign(const char *name)
+{
+    if (!name)
+        return -1;
+    if (SDL_strcmp(name, "left") == 0)
+        return NAPYS_ALIGN_LEFT;
+    if (SDL_strcmp(name, "center") == 0)
+        return NAPYS_ALIGN_CENTER;
+    if (SDL_strcmp(name, "right") == 0)
+        return NAPYS_ALIGN_RIGHT;
+    if (SDL_strcmp(name, "justify") == 0)
+        return NAPYS_ALIGN_JUSTIFY;
+
+    return -1;
+}
+
+static bool NapysMeasureCommands(NapysLayout *layout, NapysCommandList *list)
+{
+    for (int ci = 0; ci < list->cmd_count; ci++)
+    {
+        NapysCommand *cmd = &list->cmds[ci];
+
+        if (cmd->type == NAPYS_COMMAND_TYPE_DRAW_TEXT)
+        {
+            if (!NapysMeasureText(layout, cmd->data))
+            {
+                return false;
+            }
+        }
+        else if (cmd->type == NAPYS_COMMAND_TYPE_SET_COLOR)
+        {
+            NapysRegistryEntry *entry = (NapysRegistryEntry *)cmd->resolved;
+
+            if (entry)
+            {
+                layout->current_color = entry->color;
+            }
+        }
+        else if (cmd->type == NAPYS_COMMAND_TYPE_SET_FONT)
+        {
+            NapysFontCache *font_cache = (NapysFontCache *)cmd->resolved;
+
+            if (font_cache && font_cache->base)
+            {
+                NapysSetLayoutFont(layout, font_cache, layout->current_font_size);
+            }
+        }
+        else if (cmd->type == NAPYS_COMMAND_TYPE_SET_SIZE)
+        {
+            NapysRegistryEntry *entry = (NapysRegistryEntry *)cmd->resolved;
+            if (entry)
+            {
+                layout->current_font_size = entry->ptsize;
+
+                NapysSetLayoutFont(layout, layout->current_font_cache, layout->current_font_size);
+            }
+        }
+        else if (cmd->type == NAPYS_COMMAND_TYPE_NEWLINE)
+        {
+            if (!NapysAddNewlinePiece(layout))
+            {
+                return false;
+            }
+        }
+        else if (cmd->type == NAPYS_COMMAND_TYPE_DRAW_IMAGE)
+        {
+            NapysRegistryEntry *entry = (NapysRegistryEntry *)cmd->resolved;
+
+            if (entry)
+            {
+                NapysLayoutPiece *piece = NapysAddLayoutPiece(layout, NAPYS_LAYOUT_RUN_IMAGE);
+
+                if (!piece)
+                {
+                    return false;
+                }
+
+                // Lines can be broken both before and after an image, which sits on the baseline
+                piece->img = entry->img;
+                piece->img_generation = entry->img_generation;
+                piece->width = (int)entry->img_width;
+                piece->advance = piece->width;
+                piece->height = (int)entry->img_height;
+                piece->ascent = piece->height;
+                piece->descent = 0;
+                piece->flags = NAPYS_LAYOUT_PIECE_BREAK_AFTER;
+            }
+        }
+        else if (cmd->type == NAPYS_COMMAND_TYPE_USE_STRING)
+        {
+            NapysRegistryEntry *entry = (NapysRegistryEntry *)cmd->resolved;
+
+            if (entry)
+            {
+                if (!NapysMeasureText(layout, entry->str))
+                {
+                    return false;
+                }
+            }
+        }
+        else if (cmd->type == NAPYS_COMMAND_TYPE_SET_ALIGN)
+        {
+            const int align = NapysParseAlign(cmd->data);
+
+            if (align >= 0)
+            {
+                layout->current_align = align;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool NapysMeasureCommandList(NapysLayout *layout, NapysCommandList *list)
+{
+    NapysReleaseLayoutPieces(layout);
+    NapysResetLayoutFont(layout);
+
+    // Words of earlier lists pile up in the cache, so it is refilled with the words in use once it grows too large
+    if (layout->word_sizes && layout->word_sizes->count > (Uint32)layout->pieces_capacity + NAPYS_LAYOUT_WORD_SIZES_SLACK)
+    {
+        NapysDestroyHashmap(layout->word_sizes);
+        layout->word_sizes = NULL;
+    }
+
+    const bool result = NapysMeasureCommands(layout, list);
+
+    NapysReleaseCachedFont(layout->current_font_cache, layout->current_font);
+    layout->current_font = NULL;
+
+    // A failed measurement is not cached, so the list is measured again next time
+    if (result)
+    {
+        layout->pieces_list = list;
+        layout->pieces_revision = list->revision;
+        layout->pieces_cmd_count = list->cmd_count;
+        layout->pieces_generation = layout->ctx->generation;
+    }
+
+    return result;
+}
+
+// Position of the next run while breaking pieces into lines. Runs of the current line are positioned
+// relative to its baseline until the line is complete and its tallest piece is known.
+typedef struct
+{
+    int x;
+    int y;
+    int line_ascent;
+    int line_descent;
+    int line_first_run;
+    int line_align; ///< Alignment of the current line, -1 until the first piece is placed on it.
+} NapysLineCursor;
+
+static void NapysExtendLine(NapysLayout *layout, NapysLineCursor *cursor, const NapysLayoutPiece *piece)
+{
+    cursor->line_ascent = SDL_max(cursor->line_ascent, piece->ascent);
+    cursor->line_descent = SDL_min(cursor->line_descent, piece->descent);
+
+    // A line is aligned as set at its first piece
+    if (cursor->line_align < 0)
+    {
+        cursor->line_align = piece->align >= 0 ? piece->align : (int)layout->align;
+    }
+}
+
+static NapysLayoutLine *NapysAddLayoutLine(NapysLayout *layout)
+{
+    if (layout->lines_count >= layout->lines_capacity)
+    {
+        int new_capacity = layout->lines_capacity == 0 ? 8 : layout->lines_capacity * 2;
+        NapysLayoutLine *new_lines = SDL_realloc(layout->lines, new_capacity * sizeof(NapysLayoutLine));
+
+        if (!new_lines)
+        {
+            NapysSetError("Failed to allocate memory for layout lines");
+            return NULL;
+        }
+
+        layout->lines = new_lines;
+        layout->lines_capacity = new_capacity;
+    }
+
+    NapysLayoutLine *line = &layout->lines[layout->lines_count++];
+    SDL_zerop(line);
+
+    return line;
+}
+
+static bool NapysBreakLine(NapysLayout *layout, NapysLineCursor *cursor, bool wrapped)
+{
+    const int baseline = cursor->y + cursor->line_ascent;
+    int width = 0;
+
+    for (int i = cursor->line_first_run; i < layout->runs_count; i++)
+    {
+        NapysLayoutRun *run = &layout->runs[i];
+        run->y += baseline;
+
+        width = SDL_max(width, run->x + run->w);
+    }
+
+    NapysLayoutLine *line = NapysAddLayoutLine(layout);
+
+    if (line)
+    {
+        line->first_run = cursor->line_first_run;
+        line->runs_count = layout->runs_count - cursor->line_first_run;
+        line->y = cursor->y;
+        line->w = width;
+        line->h = cursor->line_ascent - cursor->line_descent;
+        line->align = cursor->line_align >= 0 ? (NapysAlign)cursor->line_align : layout->align;
+        line->wrapped = wrapped;
+    }
+
+    cursor->x = 0;
+    cursor->y = baseline - cursor->line_descent;
+    cursor->line_ascent = 0;
+    cursor->line_descent = 0;
+    cursor->line_first_run = layout->runs_count;
+    cursor->line_align = -1;
+
+    return line != NULL;
+}
+
+static bool NapysPlaceText(NapysLayout *layout, NapysLineCursor *cursor, const NapysLayoutPiece *piece,
+                           const char *text, size_t length, int width, int advance)
+{
+    NapysLayoutRun *run = layout->runs_count > cursor->line_first_run ? &layout->runs[layout->runs_count - 1] : NULL;
+
+    // Consecutive pieces with the same style on the same line are drawn as one run,
+    // except after whitespace on justified lines, where the gaps are stretched
+    const bool continues_run = run && run->type == NAPYS_LAYOUT_RUN_TEXT && run->font == piece->font &&
+                               run->font_cache == piece->font_cache && run->text + run->length == text &&
+                               SDL_memcmp(&run->color, &piece->color, sizeof(SDL_Color)) == 0 &&
+                               !(cursor->line_align == NAPYS_ALIGN_JUSTIFY && NapysIsLayoutSpace(text[-1]));
+
+    if (continues_run)
+    {
+        run->length += length;
+        run->w = cursor->x + width - run->x;
+        run->h = SDL_max(run->h, piece->height);
+    }
+    else
+    {
+        run = NapysAddLayoutRun(layout, NAPYS_LAYOUT_RUN_TEXT);
+
+        if (!run)
+        {
+            return false;
+        }
+
+        run->text = text;
+        run->length = length;
+        run->font = piece->font;
+        run->font_cache = piece->font_cache;
+        run->ptsize = piece->ptsize;
+        run->color = piece->color;
+        run->x = cursor->x;
+        run->y = -piece->ascent;
+        run->w = width;
+        run->h = piece->height;
+    }
+
+    cursor->x += advance;
+    NapysExtendLine(layout, cursor, piece);
+
+    return true;
+}
+
+static bool NapysPlacePiece(NapysLayout *layout, NapysLineCursor *cursor, const NapysLayoutPiece *piece)
+{
+    if (piece->type == NAPYS_LAYOUT_RUN_TEXT)
+    {
+        return NapysPlaceText(layout, cursor, piece, piece->text, piece->length, piece->width, piece->advance);
+    }
+
+    NapysLayoutRun *run = NapysAddLayoutRun(layout, NAPYS_LAYOUT_RUN_IMAGE);
+
+    if (!run)
+    {
+        return false;
+    }
+
+    run->img = piece->img;
+    run->img_generation = piece->img_generation;
+    run->w = piece->width;
+    run->h = piece->height;
+    run->x = cursor->x;
+    run->y = -piece->ascent;
+
+    cursor->x += piece->advance;
+    NapysExtendLine(layout, cursor, piece);
+
+    return true;
+}
+
+// Place a piece that does not fit on a line of its own, breaking it between characters
+static bool NapysPlaceSplitPiece(NapysLayout *layout, NapysLineCursor *cursor, const NapysLayoutPiece *piece)
+{
+    if (piece->type != NAPYS_LAYOUT_RUN_TEXT)
+    {
+        return NapysPlacePiece(layout, cursor, piece);
+    }
+
+    const char *text = piece->text;
+    size_t word_length = piece->length;
+
+    while (word_length > 0 && NapysIsLayoutSpace(text[word_length - 1]))
+    {
+        word_length--;
+    }
+
+    const size_t space_length = piece->length - word_length;
+    const int space_advance = piece->advance - piece->width;
+
+    while (word_length > 0)
+    {
+        // A maximum width of 0 would not limit the measurement at all
+        if (cursor->x > 0 && cursor->x >= layout->wrap_width && !NapysBreakLine(layout, cursor, true))
+        {
+            return false;
+        }
+
+        int width = 0;
+        size_t fitting_length = 0;
+
+        NapysLockFontCache(piece->font_cache);
+        TTF_MeasureString(piece->font, text, word_length, layout->wrap_width - cursor->x, &width, &fitting_length);
+
+        if (fitting_length == 0 && cursor->x == 0)
+        {
+            // Not even a single character fits, so it overflows the line on its own
+            const char *next = text;
+            size_t left = word_length;
+            SDL_StepUTF8(&next, &left);
+
+            fitting_length = SDL_max((size_t)(next - text), 1);
+            TTF_GetStringSize(piece->font, text, fitting_length, &width, NULL);
+        }
+
+        NapysUnlockFontCache(piece->font_cache);
+
+        if (fitting_length >= word_length)
+        {
+            return NapysPlaceText(layout, cursor, piece, text, word_length + space_length, width, width + space_advance);
+        }
+
+        if (fitting_length > 0 && !NapysPlaceText(layout, cursor, piece, text, fitting_length, width, width))
+        {
+            return false;
+        }
+
+        // The rest goes to the next line
+        if (!NapysBreakLine(layout, cursor, true))
+        {
+            return false;
+        }
+
+        text += fitting_length;
+        word_length -= fitting_length;
+    }
+
+    return NapysPlaceText(layout, cursor, piece, text, space_length, 0, space_advance);
+}
+
+// Break the measured pieces into lines and merge them into runs. Every piece is visited a constant number of times,
+// so re-wrapping at a different width is linear in the number of pieces and does not touch the fonts,
+// except for single words wider than the wrap width.
+static bool NapysPlaceLayoutPieces(NapysLayout *layout, NapysLineCursor *cursor)
+{
+    const bool wrap = layout->wrap_width > 0;
+    int i = 0;
+
+    while (i < layout->pieces_count)
+    {
+        const NapysLayoutPiece *piece = &layout->pieces[i];
+
+        if (piece->flags & NAPYS_LAYOUT_PIECE_NEWLINE)
+        {
+            // An empty line still takes the height of its font
+            NapysExtendLine(layout, cursor, piece);
+
+            if (!NapysBreakLine(layout, cursor, false))
+            {
+                return false;
+            }
+
+            i++;
+            continue;
+        }
+
+        // Pieces up to the next break opportunity have to stay on the same line
+        int group_end = i + 1;
+        int group_width = piece->width;
+        int group_advance = piece->advance;
+
+        while (group_end < layout->pieces_count)
+        {
+            const NapysLayoutPiece *last = &layout->pieces[group_end - 1];
+            const NapysLayoutPiece *next = &layout->pieces[group_end];
+
+            if ((last->flags & NAPYS_LAYOUT_PIECE_BREAK_AFTER) || (next->flags & NAPYS_LAYOUT_PIECE_NEWLINE) ||
+                next->type == NAPYS_LAYOUT_RUN_IMAGE)
+            {
+                break;
+            }
+
+            group_width = group_advance + next->width;
+            group_advance += next->advance;
+            group_end++;
+        }
+
+        if (wrap && cursor->x > 0 && cursor->x + group_width > layout->wrap_width &&
+            !NapysBreakLine(layout, cursor, true))
+        {
+            return false;
+        }
+
+        const bool split = wrap && group_width > layout->wrap_width;
+
+        for (; i < group_end; i++)
+        {
+            const NapysLayoutPiece *group_piece = &layout->pieces[i];
+
+            if (split && cursor->x + group_piece->width > layout->wrap_width)
+            {
+                if (!NapysPlaceSplitPiece(layout, cursor, group_piece))
+                {
+                    return false;
+                }
+            }
+            else if (!NapysPlacePiece(layout, cursor, group_piece))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Shift the runs of every line by the free space left on it. Lines are aligned within the wrap width, or within
+// the widest line, which is known only after all lines are broken, so this is done once at the end.
+static void NapysAlignLayoutLines(NapysLayout *layout)
+{
+    int box_width = layout->wrap_width;
+
+    if (box_width == 0)
+    {
+        for (int i = 0; i < layout->lines_count; i++)
+        {
+            box_width = SDL_max(box_width, layout->lines[i].w);
+        }
+    }
+
+    for (int i = 0; i < layout->lines_count; i++)
+    {
+        NapysLayoutLine *line = &layout->lines[i];
+        NapysLayoutRun *runs = &layout->runs[line->first_run];
+
+        const int free_space = box_width - line->w;
+
+        if (free_space > 0 && line->align == NAPYS_ALIGN_JUSTIFY && line->wrapped)
+        {
+            int gaps = 0;
+
+            for (int r = 0; r < line->runs_count - 1; r++)
+            {
+                gaps += runs[r].type == NAPYS_LAYOUT_RUN_TEXT && NapysIsLayoutSpace(runs[r].text[runs[r].length - 1]);
+            }
+
+            // The free space is spread over the gaps after whitespace, so the last run ends at the box edge
+            for (int r = 0, gap = 0; gaps > 0 && r < line->runs_count; r++)
+            {
+                runs[r].x += free_space * gap / gaps;
+
+                gap += runs[r].type == NAPYS_LAYOUT_RUN_TEXT && NapysIsLayoutSpace(runs[r].text[runs[r].length - 1]);
+            }
+
+            line->w += gaps > 0 ? free_space : 0;
+        }
+        else if (free_space > 0 && (line->align == NAPYS_ALIGN_CENTER || line->align == NAPYS_ALIGN_RIGHT))
+        {
+            line->x = line->align == NAPYS_ALIGN_CENTER ? free_space / 2 : free_space;
+
+            for (int r = 0; r < line->runs_count; r++)
+            {
+                runs[r].x += line->x;
+            }
+        }
+
+        for (int r = 0; r < line->runs_count; r++)
+        {
+            NapysUpdateLayoutBounds(layout, runs[r].x, runs[r].y, runs[r].w, runs[r].h);
+        }
+    }
+}
+
+static bool NapysBreakLayoutLines(NapysLayout *layout)
+{
+    NapysLineCursor cursor = {0, 0, 0, 0, 0, -1};
+
+    layout->runs_count = 0;
+    layout->lines_count = 0;
+    layout->bounds = (SDL_Rect){0, 0, 0, 0};
+
+    bool result = NapysPlaceLayoutPieces(layout, &cursor);
+
+    // Completes the last line, or the runs placed before a failure
+    if (layout->runs_count > cursor.line_first_run)
+    {
+        result = NapysBreakLine(layout, &cursor, false) && result;
+    }
+
+    NapysAlignLayoutLines(layout);
+
+    return result;
+}
+
+bool NapysLayoutCommandList(NapysLayout *layout, NapysCommandList *list)
+{
+    if (!layout || !list)
+    {
+        return NapysSetError("Invalid layout or command list");
+    }
+
+    if (!NapysEnsureCommandListCompiled(layout->ctx, list))
+    {
+        // Renderers must not keep drawing the previously laid out list
+        NapysReleaseLayoutPieces(layout);
+        layout->runs_count = 0;
+        layout->lines_count = 0;
+        layout->bounds = (SDL_Rect){0, 0, 0, 0};
+        return false;
+    }
+
+    NAPYS_PROFILE_BEGIN("NapysLayoutCommandList", layout);
+    const Uint64 start = SDL_GetTicksNS();
+
+    const bool measured = layout->pieces_list == list && layout->pieces_revision == list->revision &&
+                          layout->pieces_cmd_count == list->cmd_count &&
+                          layout->pieces_generation == layout->ctx->generation;
+
+    // A failed measurement still lays out the pieces measured before the failure
+    const bool result = measured || NapysMeasureCommandList(layout, list);
+
+    const bool broken = NapysBreakLayoutLines(layout);
+
+    const NapysContextStats stats = {.layout_ns = SDL_GetTicksNS() - start};
+    NapysAddContextStats(layout->ctx, &stats);
+    NAPYS_PROFILE_END("NapysLayoutCommandList", layout);
+
+    return broken && result;
+}
+
+bool NapysGetLayoutBounds(NapysLayout *layout, SDL_Rect *output)
+{
+    if (!layout)
+    {
+        return NapysSetError("Invalid layout");
+    }
+
+    if (output)
+    {
+        *output = layout->bounds;
+    }
+
+    return true;
+}
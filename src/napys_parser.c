@@ -1,128 +1,166 @@
 #include <napys.h>
 #include "napys_internal.h"
 
-static void NapysParseRichTextTag(const char *tag, NapysCommandList *cmd_list)
+static bool NapysTagNameEquals(const char *name, size_t name_length, const char *expected)
 {
-    const char *delimeter = SDL_strstr(tag, ":");
+    return SDL_strlen(expected) == name_length && SDL_strncmp(name, expected, name_length) == 0;
+}
+
+// Parses the tag contents in place: the name and the value are terminated by overwriting the delimiter
+static void NapysParseRichTextTag(char *tag, size_t length, NapysCommandList *cmd_list)
+{
+    char *delimeter = NULL;
 
-    const char *cmd_name = SDL_strndup(tag, delimeter - tag);
-    const char *cmd_value = delimeter != NULL ? SDL_strndup(delimeter + 1, SDL_strlen(tag) - (delimeter - tag) - 1) : NULL;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (tag[i] == ':')
+        {
+            delimeter = tag + i;
+            break;
+        }
+    }
 
-    NapysCommand cmd = {0};
-    cmd.type = NAPYS_COMMAND_TYPE_NONE;
+    char *cmd_name = tag;
+    const size_t cmd_name_length = delimeter != NULL ? (size_t)(delimeter - tag) : length;
 
-    if (SDL_strncmp(cmd_name, "color", 5) == 0 && cmd_value)
+    char *cmd_value = delimeter != NULL ? delimeter + 1 : NULL;
+    const size_t cmd_value_length = delimeter != NULL ? length - cmd_name_length - 1 : 0;
+
+    if (delimeter)
     {
-        cmd.type = NAPYS_COMMAND_TYPE_SET_COLOR;
-        cmd.data = SDL_strdup(cmd_value);
+        *delimeter = '\0';
     }
-    else if (SDL_strncmp(cmd_name, "font", 4) == 0 && cmd_value)
+
+    if (NapysTagNameEquals(cmd_name, cmd_name_length, "color") && cmd_value)
     {
-        cmd.type = NAPYS_COMMAND_TYPE_SET_FONT;
-        cmd.data = SDL_strdup(cmd_value);
+        NapysPushCommand(cmd_list, NAPYS_COMMAND_TYPE_SET_COLOR, cmd_value);
     }
-    else if (SDL_strncmp(cmd_name, "size", 4) == 0 && cmd_value)
+    else if (NapysTagNameEquals(cmd_name, cmd_name_length, "font") && cmd_value)
     {
-        cmd.type = NAPYS_COMMAND_TYPE_SET_SIZE;
-        cmd.data = SDL_strdup(cmd_value);
+        NapysPushCommand(cmd_list, NAPYS_COMMAND_TYPE_SET_FONT, cmd_value);
     }
-    else if (cmd_value && SDL_strlen(cmd_name) == 0 && SDL_strncmp(cmd_value, "newline", 7) == 0)
+    else if (NapysTagNameEquals(cmd_name, cmd_name_length, "size") && cmd_value)
     {
-        cmd.type = NAPYS_COMMAND_TYPE_NEWLINE;
+        NapysPushCommand(cmd_list, NAPYS_COMMAND_TYPE_SET_SIZE, cmd_value);
     }
-    else if (SDL_strncmp(cmd_name, "image", 5) == 0 && cmd_value)
+    else if (cmd_value && cmd_name_length == 0 && NapysTagNameEquals(cmd_value, cmd_value_length, "newline"))
     {
-        cmd.type = NAPYS_COMMAND_TYPE_DRAW_IMAGE;
-        cmd.data = SDL_strdup(cmd_value);
+        NapysPushCommand(cmd_list, NAPYS_COMMAND_TYPE_NEWLINE, NULL);
     }
-    else
+    else if (NapysTagNameEquals(cmd_name, cmd_name_length, "image") && cmd_value)
     {
-        cmd.type = NAPYS_COMMAND_TYPE_USE_STRING;
-        cmd.data = SDL_strdup(cmd_name);
+        NapysPushCommand(cmd_list, NAPYS_COMMAND_TYPE_DRAW_IMAGE, cmd_value);
     }
-
-    SDL_free((void *)cmd_name);
-    SDL_free((void *)cmd_value);
-
-    if (cmd.type != NAPYS_COMMAND_TYPE_NONE)
+    else if (NapysTagNameEquals(cmd_name, cmd_name_length, "align") && cmd_value)
+    {
+        NapysPushCommand(cmd_list, NAPYS_COMMAND_TYPE_SET_ALIGN, cmd_value);
+    }
+    else
     {
-        NapysAddCommand(cmd_list, cmd);
+        NapysPushCommand(cmd_list, NAPYS_COMMAND_TYPE_USE_STRING, cmd_name);
     }
 }
 
-NapysCommandList *NapysParseRichText(const char *text, const NapysRichTextOptions *options)
+static NapysCommandList *NapysParseSource(const char *text, const NapysRichTextOptions *options)
 {
-    NapysCommandList *cmd_list = NapysCreateCommandList();
+    if (!text)
+    {
+        NapysSetError("Invalid rich text");
+        return NULL;
+    }
 
     const char *left_tag = options && options->left_tag ? options->left_tag : "{{";
     const char *right_tag = options && options->right_tag ? options->right_tag : "}}";
     const bool treat_newline_chars_as_commands = options ? options->treat_newline_chars_as_commands : false;
 
-    const int len = SDL_strlen(text);
+    const size_t len = SDL_strlen(text);
+
+    const size_t lt_len = SDL_strlen(left_tag);
+    const size_t rt_len = SDL_strlen(right_tag);
+
+    if (lt_len == 0 || rt_len == 0)
+    {
+        NapysSetError("Rich text tags cannot be empty");
+        return NULL;
+    }
+
+    NapysCommandList *cmd_list = NapysCreateCommandList();
+
+    if (!cmd_list)
+    {
+        return NULL;
+    }
 
-    const int lt_len = SDL_strlen(left_tag);
-    const int rt_len = SDL_strlen(right_tag);
+    // The source is copied once into the list string pool and parsed in place:
+    // every command points into this copy, terminated by overwriting the delimiter that follows it.
+    char *source = NapysArenaStrndup(cmd_list->strings, text, len);
 
-    const char *cursor = text;
+    if (!source)
+    {
+        NapysSetError("Failed to allocate memory for rich text");
+        NapysDestroyCommandList(cmd_list);
+        return NULL;
+    }
 
-    const char *last_text_start = text;
+    char *const end = source + len;
 
-    const char *buffer = SDL_calloc(1, len + 1);
+    char *cursor = source;
 
-    while (cursor < text + len)
+    char *last_text_start = source;
+
+    // Plain text is skipped in bulk, stopping only on the bytes that may start a command
+    const char newline_char = treat_newline_chars_as_commands ? '\n' : left_tag[0];
+
+    while (cursor < end)
     {
+        cursor = (char *)NapysFindDelimiter(cursor, end, left_tag[0], newline_char);
+
+        if (cursor >= end)
+        {
+            break;
+        }
+
         const char cc = *cursor;
-        const int index = cursor - text;
 
-        if (cc == left_tag[0] && index + lt_len <= len)
+        if (cc == left_tag[0] && (size_t)(end - cursor) >= lt_len && SDL_strncmp(cursor, left_tag, lt_len) == 0)
         {
-            if (SDL_strncmp(cursor, left_tag, lt_len) == 0)
+            char *tag_start = cursor + lt_len;
+
+            // Try to find the ending right tag
+            char *end_tag = (char *)NapysFindString(tag_start, end, right_tag, rt_len);
+
+            if (!end_tag)
+            {
+                NapysSetError("Unmatched left tag in rich text");
+                NapysDestroyCommandList(cmd_list);
+                return NULL;
+            }
+
+            // If tag found, add the last text segment before the tag
+            if (last_text_start < cursor)
             {
-                // Skip the left tag
-                cursor += SDL_strlen(left_tag);
-
-                // Try to find the ending right tag
-                const char *end_tag = SDL_strnstr(cursor, right_tag, len - index - lt_len);
-
-                if (end_tag)
-                {
-                    // If tag found, add the last text segment before the tag
-                    if (last_text_start < cursor - lt_len)
-                    {
-                        const char *text_content = SDL_strndup(last_text_start, cursor - lt_len - last_text_start);
-                        NapysAddDrawTextCommand(cmd_list, text_content);
-                        SDL_free((void *)text_content); // Add draw text command makes a copy of the string
-                    }
-
-                    // Add the tag command
-                    const char *tag_content = SDL_strndup(cursor, end_tag - cursor);
-                    NapysParseRichTextTag(tag_content, cmd_list);
-                    SDL_free((void *)tag_content);
-
-                    // Skip the right tag
-                    cursor = end_tag + rt_len;
-                    last_text_start = cursor;
-                }
-                else
-                {
-                    NapysSetError("Unmatched left tag in rich text");
-                    NapysDestroyCommandList(cmd_list);
-                    SDL_free((void *)buffer);
-                    return NULL;
-                }
+                *cursor = '\0';
+                NapysPushCommand(cmd_list, NAPYS_COMMAND_TYPE_DRAW_TEXT, last_text_start);
             }
+
+            // Add the tag command
+            *end_tag = '\0';
+            NapysParseRichTextTag(tag_start, end_tag - tag_start, cmd_list);
+
+            // Skip the right tag
+            cursor = end_tag + rt_len;
+            last_text_start = cursor;
         }
         else if (treat_newline_chars_as_commands && cc == '\n')
         {
             // If newline character is treated as a command, add a newline command
             if (last_text_start < cursor)
             {
-                const char *text_content = SDL_strndup(last_text_start, cursor - last_text_start);
-                NapysAddDrawTextCommand(cmd_list, text_content);
-                SDL_free((void *)text_content); // Add draw text command makes a copy of the string
+                *cursor = '\0';
+                NapysPushCommand(cmd_list, NAPYS_COMMAND_TYPE_DRAW_TEXT, last_text_start);
             }
 
-            NapysAddNewlineCommand(cmd_list);
+            NapysPushCommand(cmd_list, NAPYS_COMMAND_TYPE_NEWLINE, NULL);
             last_text_start = cursor + 1;
             cursor++;
         }
@@ -132,13 +170,22 @@ NapysCommandList *NapysParseRichText(const char *text, const NapysRichTextOption
         }
     }
 
-    if (last_text_start < cursor && cursor < text + len)
+    if (last_text_start < end)
     {
-        // Add the last text segment after the last tag
-        const char *text_content = SDL_strndup(last_text_start, cursor - last_text_start);
-        NapysAddDrawTextCommand(cmd_list, text_content);
-        SDL_free((void *)text_content); // Add draw text command makes a copy of the string
+        // Add the last text segment after the last tag, already terminated by the end of the source
+        NapysPushCommand(cmd_list, NAPYS_COMMAND_TYPE_DRAW_TEXT, last_text_start);
     }
 
     return cmd_list;
 }
+
+NapysCommandList *NapysParseRichText(const char *text, const NapysRichTextOptions *options)
+{
+    NAPYS_PROFILE_BEGIN("NapysParseRichText", text);
+
+    NapysCommandList *cmd_list = NapysParseSource(text, options);
+
+    NAPYS_PROFILE_END("NapysParseRichText", text);
+
+    return cmd_list;
+}
@@ -0,0 +1,517 @@
+#include <napys.h>
+#include "napys_internal.h"
+
+NapysRendererAtlas *NapysCreateRendererAtlas(NapysContext *ctx, SDL_Renderer *renderer)
+{
+    if (!ctx || !renderer)
+    {
+        NapysSetError("Invalid context or renderer");
+        return NULL;
+    }
+
+    NapysGlyphAtlas *atlas = NapysCreateGlyphAtlas(renderer);
+
+    if (!atlas)
+    {
+        return NULL;
+    }
+
+    NapysRendererAtlas *rdr = NapysCreateSharedRendererAtlas(ctx, atlas);
+
+    if (!rdr)
+    {
+        NapysDestroyGlyphAtlas(atlas);
+        return NULL;
+    }
+
+    rdr->owns_atlas = true;
+
+    return rdr;
+}
+
+NapysRendererAtlas *NapysCreateSharedRendererAtlas(NapysContext *ctx, NapysGlyphAtlas *atlas)
+{
+    if (!ctx || !atlas)
+    {
+        NapysSetError("Invalid context or glyph atlas");
+        return NULL;
+    }
+
+    NapysRendererAtlas *rdr = SDL_calloc(1, sizeof(NapysRendererAtlas));
+
+    if (!rdr)
+    {
+        NapysSetError("Failed to allocate memory for NapysRendererAtlas");
+        return NULL;
+    }
+
+    rdr->layout = NapysCreateLayout(ctx);
+
+    if (!rdr->layout)
+    {
+        SDL_free(rdr);
+        return NULL;
+    }
+
+    rdr->ctx = ctx;
+    rdr->sdl_renderer = NapysGetAtlasRenderer(atlas);
+    rdr->atlas = atlas;
+    rdr->owns_atlas = false;
+
+    return rdr;
+}
+
+void NapysDestroyRendererAtlas(NapysRendererAtlas *renderer)
+{
+    if (renderer)
+    {
+        if (renderer->owns_atlas)
+        {
+            NapysDestroyGlyphAtlas(renderer->atlas);
+        }
+
+        NapysDestroyLayout(renderer->layout);
+
+        SDL_free(renderer->vertices);
+        SDL_free(renderer->draw_vertices);
+        SDL_free(renderer->quad_pages);
+        SDL_free(renderer->indices);
+        SDL_free(renderer->ranges);
+        SDL_free(renderer);
+    }
+}
+
+bool NapysSetAtlasWrapWidth(NapysRendererAtlas *renderer, int wrap_width)
+{
+    if (!renderer)
+    {
+        return NapysSetError("Invalid renderer");
+    }
+
+    return NapysSetLayoutWrapWidth(renderer->layout, wrap_width);
+}
+
+bool NapysSetAtlasAlign(NapysRendererAtlas *renderer, NapysAlign align)
+{
+    if (!renderer)
+    {
+        return NapysSetError("Invalid renderer");
+    }
+
+    return NapysSetLayoutAlign(renderer->layout, align);
+}
+
+static bool NapysReserveAtlasQuad(NapysRendererAtlas *rdr)
+{
+    if (rdr->vertices_count + 4 <= rdr->vertices_capacity)
+    {
+        return true;
+    }
+
+    const int new_capacity = rdr->vertices_capacity == 0 ? 256 : rdr->vertices_capacity * 2;
+
+    SDL_Vertex *new_vertices = SDL_realloc(rdr->vertices, new_capacity * sizeof(SDL_Vertex));
+    if (!new_vertices)
+    {
+        return NapysSetError("Failed to allocate memory for atlas vertices");
+    }
+    rdr->vertices = new_vertices;
+
+    SDL_Vertex *new_draw_vertices = SDL_realloc(rdr->draw_vertices, new_capacity * sizeof(SDL_Vertex));
+    if (!new_draw_vertices)
+    {
+        return NapysSetError("Failed to allocate memory for atlas vertices");
+    }
+    rdr->draw_vertices = new_draw_vertices;
+
+    int *new_quad_pages = SDL_realloc(rdr->quad_pages, (new_capacity / 4) * sizeof(int));
+    if (!new_quad_pages)
+    {
+        return NapysSetError("Failed to allocate memory for atlas vertices");
+    }
+    rdr->quad_pages = new_quad_pages;
+
+    rdr->vertices_capacity = new_capacity;
+
+    return true;
+}
+
+// The quad is w x h pixels, which differs from the pixels in the atlas for images registered at another size
+static void NapysPushAtlasQuad(NapysRendererAtlas *rdr, const NapysAtlasGlyph *glyph, float x, float y, float w, float h,
+                               SDL_FColor color)
+{
+    if (!NapysReserveAtlasQuad(rdr))
+    {
+        return;
+    }
+
+    const float inv_page_size = 1.0f / NAPYS_GLYPH_ATLAS_PAGE_SIZE;
+
+    const float x0 = x;
+    const float y0 = y;
+    const float x1 = x + w;
+    const float y1 = y + h;
+
+    const float u0 = glyph->rect.x * inv_page_size;
+    const float v0 = glyph->rect.y * inv_page_size;
+    const float u1 = (glyph->rect.x + glyph->rect.w) * inv_page_size;
+    const float v1 = (glyph->rect.y + glyph->rect.h) * inv_page_size;
+
+    SDL_Vertex *quad = &rdr->vertices[rdr->vertices_count];
+
+    quad[0] = (SDL_Vertex){{x0, y0}, color, {u0, v0}};
+    quad[1] = (SDL_Vertex){{x1, y0}, color, {u1, v0}};
+    quad[2] = (SDL_Vertex){{x0, y1}, color, {u0, v1}};
+    quad[3] = (SDL_Vertex){{x1, y1}, color, {u1, v1}};
+
+    rdr->quad_pages[rdr->vertices_count / 4] = glyph->page;
+    rdr->vertices_count += 4;
+}
+
+static void NapysAddAtlasTextRun(NapysRendererAtlas *rdr, const NapysLayoutRun *run)
+{
+    const SDL_FColor color = {
+        run->color.r / 255.0f,
+        run->color.g / 255.0f,
+        run->color.b / 255.0f,
+        run->color.a / 255.0f,
+    };
+
+    const char *cursor = run->text;
+    size_t left = run->length;
+
+    int pen_x = run->x;
+    Uint32 previous = 0;
+
+    while (left > 0)
+    {
+        const Uint32 codepoint = SDL_StepUTF8(&cursor, &left);
+
+        if (codepoint == 0)
+        {
+            break;
+        }
+
+        if (previous)
+        {
+            int kerning = 0;
+
+            NapysLockFontCache(run->font_cache);
+            if (TTF_GetGlyphKerning(run->font, previous, codepoint, &kerning))
+            {
+                pen_x += kerning;
+            }
+            NapysUnlockFontCache(run->font_cache);
+        }
+
+        const NapysAtlasGlyph *glyph = NapysGetAtlasGlyph(rdr->atlas, run->font_cache, run->font, run->ptsize, codepoint);
+
+        if (glyph)
+        {
+            if (glyph->page >= 0)
+            {
+                NapysPushAtlasQuad(rdr, glyph, (float)(pen_x + glyph->offset_x), (float)run->y, (float)glyph->rect.w,
+                                   (float)glyph->rect.h, color);
+            }
+
+            pen_x += glyph->advance;
+        }
+
+        previous = codepoint;
+    }
+}
+
+// Group the quads by atlas page with a counting sort, so every page is drawn in a single call
+static void NapysBuildAtlasRanges(NapysRendererAtlas *rdr)
+{
+    const int quad_count = rdr->vertices_count / 4;
+
+    if (quad_count == 0)
+    {
+        return;
+    }
+
+    int pages_count = 0;
+
+    for (int q = 0; q < quad_count; q++)
+    {
+        if (rdr->quad_pages[q] + 1 > pages_count)
+        {
+            pages_count = rdr->quad_pages[q] + 1;
+        }
+    }
+
+    if (pages_count > rdr->ranges_capacity)
+    {
+        NapysAtlasDrawRange *new_ranges = SDL_realloc(rdr->ranges, pages_count * sizeof(NapysAtlasDrawRange));
+
+        if (!new_ranges)
+        {
+            NapysSetError("Failed to allocate memory for atlas draw ranges");
+            return;
+        }
+
+        rdr->ranges = new_ranges;
+        rdr->ranges_capacity = pages_count;
+    }
+
+    for (int p = 0; p < pages_count; p++)
+    {
+        rdr->ranges[p] = (NapysAtlasDrawRange){p, 0, 0};
+    }
+
+    for (int q = 0; q < quad_count; q++)
+    {
+        rdr->ranges[rdr->quad_pages[q]].quad_count++;
+    }
+
+    int first_vertex = 0;
+    int largest_range = 0;
+
+    for (int p = 0; p < pages_count; p++)
+    {
+        rdr->ranges[p].first_vertex = first_vertex;
+        first_vertex += rdr->ranges[p].quad_count * 4;
+
+        if (rdr->ranges[p].quad_count > largest_range)
+        {
+            largest_range = rdr->ranges[p].quad_count;
+        }
+    }
+
+    if (pages_count > 1)
+    {
+        int *next_vertex = SDL_stack_alloc(int, pages_count);
+
+        for (int p = 0; p < pages_count; p++)
+        {
+            next_vertex[p] = rdr->ranges[p].first_vertex;
+        }
+
+        for (int q = 0; q < quad_count; q++)
+        {
+            const int page = rdr->quad_pages[q];
+
+            SDL_memcpy(&rdr->draw_vertices[next_vertex[page]], &rdr->vertices[q * 4], 4 * sizeof(SDL_Vertex));
+            next_vertex[page] += 4;
+        }
+
+        SDL_stack_free(next_vertex);
+
+        SDL_Vertex *sorted = rdr->draw_vertices;
+        rdr->draw_vertices = rdr->vertices;
+        rdr->vertices = sorted;
+    }
+
+    // Drop the ranges of pages not used by this label
+    int used_ranges = 0;
+
+    for (int p = 0; p < pages_count; p++)
+    {
+        if (rdr->ranges[p].quad_count > 0)
+        {
+            rdr->ranges[used_ranges++] = rdr->ranges[p];
+        }
+    }
+
+    rdr->ranges_count = used_ranges;
+
+    // Without indices for the largest range nothing can be drawn, so the label is left empty
+    if (!NapysBuildQuadIndices(&rdr->indices, &rdr->indices_capacity, largest_range))
+    {
+        rdr->ranges_count = 0;
+        return;
+    }
+
+    SDL_memcpy(rdr->draw_vertices, rdr->vertices, rdr->vertices_count * sizeof(SDL_Vertex));
+    rdr->draw_x_offset = 0;
+    rdr->draw_y_offset = 0;
+}
+
+void NapysExecuteCommandListAtlas(NapysRendererAtlas *rdr, NapysCommandList *list)
+{
+    if (!rdr || !list)
+    {
+        NapysSetError("Invalid renderer or command list");
+        return;
+    }
+
+    // A failed layout keeps only the runs laid out before the failure
+    NapysLayoutCommandList(rdr->layout, list);
+
+    NapysExecuteLayoutAtlas(rdr, rdr->layout);
+}
+
+void NapysExecuteLayoutAtlas(NapysRendererAtlas *rdr, const NapysLayout *layout)
+{
+    if (!rdr || !layout)
+    {
+        NapysSetError("Invalid renderer or layout");
+        return;
+    }
+
+    rdr->vertices_count = 0;
+    rdr->ranges_count = 0;
+    rdr->bounds = layout->bounds;
+    rdr->atlas_epoch = NapysGetAtlasEpoch(rdr->atlas);
+
+    for (int i = 0; i < layout->runs_count; i++)
+    {
+        const NapysLayoutRun *run = &layout->runs[i];
+
+        if (run->type == NAPYS_LAYOUT_RUN_TEXT)
+        {
+            NapysAddAtlasTextRun(rdr, run);
+        }
+        else if (run->img)
+        {
+            const NapysAtlasGlyph *image = NapysGetAtlasImage(rdr->atlas, (SDL_Texture *)run->img, run->img_generation);
+
+            if (image)
+            {
+                NapysPushAtlasQuad(rdr, image, (float)run->x, (float)run->y, (float)run->w, (float)run->h,
+                                   (SDL_FColor){1.0f, 1.0f, 1.0f, 1.0f});
+            }
+        }
+    }
+
+    NapysBuildAtlasRanges(rdr);
+}
+
+void NapysRenderAtlas(NapysRendererAtlas *renderer, float x, float y)
+{
+    if (!renderer || !renderer->atlas)
+    {
+        NapysSetError("Invalid renderer or glyph atlas");
+        return;
+    }
+
+    // The glyphs of the label were removed from the atlas, it must be executed again
+    if (renderer->atlas_epoch != NapysGetAtlasEpoch(renderer->atlas))
+    {
+        return;
+    }
+
+    // Vertices are translated only when the label moves, so static labels are submitted as is
+    if (x != renderer->draw_x_offset || y != renderer->draw_y_offset)
+    {
+        for (int i = 0; i < renderer->vertices_count; i++)
+        {
+            renderer->draw_vertices[i] = renderer->vertices[i];
+            renderer->draw_vertices[i].position.x += x;
+            renderer->draw_vertices[i].position.y += y;
+        }
+
+        renderer->draw_x_offset = x;
+        renderer->draw_y_offset = y;
+    }
+
+    for (int i = 0; i < renderer->ranges_count; i++)
+    {
+        const NapysAtlasDrawRange *range = &renderer->ranges[i];
+
+        SDL_RenderGeometry(renderer->sdl_renderer, NapysGetAtlasPage(renderer->atlas, range->page),
+                           &renderer->draw_vertices[range->first_vertex], range->quad_count * 4,
+                           renderer->indices, range->quad_count * 6);
+    }
+}
+
+bool NapysGetAtlasRenderedTextBounds(NapysRendererAtlas *renderer, SDL_Rect *output)
+{
+    if (!renderer)
+    {
+        return NapysSetError("Invalid renderer");
+    }
+
+    if (output)
+    {
+        *output = renderer->bounds;
+    }
+
+    return true;
+}
+
+bool NapysRenderAtlasBatch(NapysGlyphAtlas *atlas, const NapysAtlasPlacement *placements, int count)
+{
+    if (!atlas || (!placements && count > 0))
+    {
+        return NapysSetError("Invalid glyph atlas or placements");
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!placements[i].label || placements[i].label->atlas != atlas)
+        {
+            return NapysSetError("Batched label does not use the given glyph atlas");
+        }
+    }
+
+    const int pages_count = NapysGetGlyphAtlasPageCount(atlas);
+    const Uint32 epoch = NapysGetAtlasEpoch(atlas);
+
+    for (int page = 0; page < pages_count; page++)
+    {
+        // Size the merged geometry of this page first, so the scratch buffers are grown at most once
+        int quad_count = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            const NapysRendererAtlas *label = placements[i].label;
+
+            // Labels executed before the atlas was cleared are skipped, as in NapysRenderAtlas()
+            for (int r = 0; label->atlas_epoch == epoch && r < label->ranges_count; r++)
+            {
+                if (label->ranges[r].page == page)
+                {
+                    quad_count += label->ranges[r].quad_count;
+                }
+            }
+        }
+
+        if (quad_count == 0)
+        {
+            continue;
+        }
+
+        SDL_Vertex *vertices = NapysReserveAtlasBatchVertices(atlas, quad_count * 4);
+        const int *indices = NapysReserveAtlasBatchIndices(atlas, quad_count);
+
+        if (!vertices || !indices)
+        {
+            return false;
+        }
+
+        int vertices_count = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            const NapysRendererAtlas *label = placements[i].label;
+            const float x = placements[i].x;
+            const float y = placements[i].y;
+
+            for (int r = 0; label->atlas_epoch == epoch && r < label->ranges_count; r++)
+            {
+                const NapysAtlasDrawRange *range = &label->ranges[r];
+
+                if (range->page != page)
+                {
+                    continue;
+                }
+
+                const SDL_Vertex *src = &label->vertices[range->first_vertex];
+
+                for (int v = 0; v < range->quad_count * 4; v++)
+                {
+                    vertices[vertices_count] = src[v];
+                    vertices[vertices_count].position.x += x;
+                    vertices[vertices_count].position.y += y;
+                    vertices_count++;
+                }
+            }
+        }
+
+        SDL_RenderGeometry(NapysGetAtlasRenderer(atlas), NapysGetAtlasPage(atlas, page), vertices, vertices_count, indices, quad_count * 6);
+    }
+
+    return true;
+}
@@ -1,18 +1,6 @@
 #include <napys.h>
 #include "napys_internal.h"
 
-static void NapysResetRendererTTF(NapysRendererTTF *rdr)
-{
-    rdr->current_color = (SDL_Color){255, 255, 255, 255};
-    rdr->fragments_count = 0;
-    rdr->current_font_size = 12;
-    rdr->draw_x = 0;
-    rdr->draw_y = 0;
-    rdr->bounds = (SDL_Rect){0, 0, 0, 0};
-    rdr->fragment_pointer = 0;
-    rdr->current_font_cache = rdr->ctx->default_font_cache;
-}
-
 NapysRendererTTF *NapysCreateRendererTTF(NapysContext *ctx, SDL_Renderer *renderer)
 {
     if (!ctx || !renderer)
@@ -28,21 +16,29 @@ NapysRendererTTF *NapysCreateRendererTTF(NapysContext *ctx, SDL_Renderer *render
         return NULL;
     }
 
-    NapysRendererTTF *nrttf = SDL_malloc(sizeof(NapysRendererTTF));
+    NapysRendererTTF *nrttf = SDL_calloc(1, sizeof(NapysRendererTTF));
 
     if (!nrttf)
     {
+        TTF_DestroyRendererTextEngine(engine);
         NapysSetError("Failed to allocate memory for NapysRendererTTF");
         return NULL;
     }
 
+    nrttf->layout = NapysCreateLayout(ctx);
+
+    if (!nrttf->layout)
+    {
+        TTF_DestroyRendererTextEngine(engine);
+        SDL_free(nrttf);
+        return NULL;
+    }
+
     nrttf->ctx = ctx;
     nrttf->engine = engine;
     nrttf->sdl_renderer = renderer;
-
-    SDL_memset(nrttf->fragments, 0, sizeof(nrttf->fragments));
-
-    NapysResetRendererTTF(nrttf);
+    nrttf->revealed_glyphs = -1;
+    nrttf->reveal_fragment = -1;
 
     return nrttf;
 }
@@ -51,206 +47,696 @@ void NapysDestroyRendererTTF(NapysRendererTTF *renderer)
 {
     if (renderer)
     {
+        for (int i = 0; i < renderer->fragments_count; i++)
+        {
+            NapysFragmentTTF *fragment = &renderer->fragments[i];
+
+            if (fragment->text)
+            {
+                NapysReleaseCachedFont(fragment->font_cache, fragment->font);
+                TTF_DestroyText(fragment->text);
+            }
+        }
+
+        for (int i = 0; i < renderer->free_texts_count; i++)
+        {
+            TTF_DestroyText(renderer->free_texts[i]);
+        }
+
+        if (renderer->reveal_text)
+        {
+            TTF_DestroyText(renderer->reveal_text);
+        }
+
+        // Texts must be destroyed before the engine they were created with
+        TTF_DestroyRendererTextEngine(renderer->engine);
+
+        NapysDestroyLayout(renderer->layout);
+
+        if (renderer->cache_texture)
+        {
+            SDL_DestroyTexture(renderer->cache_texture);
+        }
+
+        SDL_free(renderer->lines);
+        SDL_free(renderer->fragments);
+        SDL_free(renderer->free_texts);
         SDL_free(renderer);
     }
 }
 
-static NapysFragmentTTF *NapysGetNextTextFragment(NapysRendererTTF *rdr, const char *contents)
+bool NapysSetWrapWidth(NapysRendererTTF *renderer, int wrap_width)
 {
-    if (rdr->fragment_pointer >= NAPYS_TTF_RENDERER_MAX_TEXTS)
+    if (!renderer)
     {
-        NapysSetError("Maximum number of text fragments reached");
-        return NULL;
+        return NapysSetError("Invalid renderer");
+    }
+
+    return NapysSetLayoutWrapWidth(renderer->layout, wrap_width);
+}
+
+bool NapysSetAlign(NapysRendererTTF *renderer, NapysAlign align)
+{
+    if (!renderer)
+    {
+        return NapysSetError("Invalid renderer");
+    }
+
+    return NapysSetLayoutAlign(renderer->layout, align);
+}
+
+bool NapysSetLazyTexts(NapysRendererTTF *renderer, bool lazy_texts)
+{
+    if (!renderer)
+    {
+        return NapysSetError("Invalid renderer");
+    }
+
+    renderer->lazy_texts = lazy_texts;
+
+    return true;
+}
+
+bool NapysSetTextureCache(NapysRendererTTF *renderer, bool texture_cache)
+{
+    if (!renderer)
+    {
+        return NapysSetError("Invalid renderer");
+    }
+
+    if (!texture_cache && renderer->cache_texture)
+    {
+        SDL_DestroyTexture(renderer->cache_texture);
+        renderer->cache_texture = NULL;
+    }
+
+    renderer->texture_cache = texture_cache;
+    renderer->cache_valid = false;
+
+    return true;
+}
+
+bool NapysSetRevealedGlyphs(NapysRendererTTF *renderer, int count)
+{
+    if (!renderer)
+    {
+        return NapysSetError("Invalid renderer");
+    }
+
+    renderer->revealed_glyphs = count < 0 ? -1 : count;
+
+    return true;
+}
+
+bool NapysGetGlyphCount(NapysRendererTTF *renderer, int *count)
+{
+    if (!renderer || !count)
+    {
+        return NapysSetError("Invalid renderer or count");
+    }
+
+    *count = renderer->glyphs_count;
+
+    return true;
+}
+
+bool NapysGetRendererStats(NapysRendererTTF *renderer, NapysRendererStats *stats)
+{
+    if (!renderer || !stats)
+    {
+        return NapysSetError("Invalid renderer or stats");
+    }
+
+    *stats = renderer->stats;
+
+    return true;
+}
+
+bool NapysResetRendererStats(NapysRendererTTF *renderer)
+{
+    if (!renderer)
+    {
+        return NapysSetError("Invalid renderer");
+    }
+
+    SDL_zero(renderer->stats);
+
+    return true;
+}
+
+static NapysFragmentTTF *NapysGetFragmentSlot(NapysRendererTTF *rdr)
+{
+    if (rdr->fragment_pointer >= rdr->fragments_capacity)
+    {
+        int new_capacity = rdr->fragments_capacity == 0 ? NAPYS_TTF_RENDERER_INITIAL_FRAGMENTS : rdr->fragments_capacity * 2;
+        NapysFragmentTTF *new_fragments = SDL_realloc(rdr->fragments, new_capacity * sizeof(NapysFragmentTTF));
+
+        if (!new_fragments)
+        {
+            NapysSetError("Failed to allocate memory for text fragments");
+            return NULL;
+        }
+
+        SDL_memset(new_fragments + rdr->fragments_capacity, 0, (new_capacity - rdr->fragments_capacity) * sizeof(NapysFragmentTTF));
+
+        rdr->stats.bytes_allocated += new_capacity * sizeof(NapysFragmentTTF);
+
+        rdr->fragments = new_fragments;
+        rdr->fragments_capacity = new_capacity;
     }
 
-    if (rdr->fragment_pointer < rdr->fragments_count)
+    return &rdr->fragments[rdr->fragment_pointer];
+}
+
+static void NapysReleaseText(NapysRendererTTF *rdr, TTF_Text *text)
+{
+    // Pooled texts must not reference fonts, which may be closed by the font cache in the meantime
+    TTF_SetTextFont(text, NULL);
+
+    // The pool only needs to absorb the usual fluctuation of the fragment count between executions
+    if (rdr->free_texts_count >= NAPYS_TTF_RENDERER_MAX_FREE_TEXTS)
     {
-        return &rdr->fragments[rdr->fragment_pointer++];
+        TTF_DestroyText(text);
+        rdr->stats.fragments_destroyed++;
+        return;
+    }
+
+    if (rdr->free_texts_count >= rdr->free_texts_capacity)
+    {
+        int new_capacity = rdr->free_texts_capacity == 0 ? NAPYS_TTF_RENDERER_INITIAL_FRAGMENTS : rdr->free_texts_capacity * 2;
+        TTF_Text **new_texts = SDL_realloc(rdr->free_texts, new_capacity * sizeof(TTF_Text *));
+
+        if (!new_texts)
+        {
+            // Cannot keep it for later, so just get rid of it
+            TTF_DestroyText(text);
+            rdr->stats.fragments_destroyed++;
+            return;
+        }
+
+        rdr->stats.bytes_allocated += new_capacity * sizeof(TTF_Text *);
+
+        rdr->free_texts = new_texts;
+        rdr->free_texts_capacity = new_capacity;
     }
 
-    TTF_Text *ttf_text = TTF_CreateText(rdr->engine, rdr->current_font, contents, 0);
+    rdr->free_texts[rdr->free_texts_count++] = text;
+}
+
+static void NapysReleaseTextFragment(NapysRendererTTF *rdr, NapysFragmentTTF *fragment)
+{
+    NapysReleaseCachedFont(fragment->font_cache, fragment->font);
+    NapysReleaseText(rdr, fragment->text);
+
+    fragment->text = NULL;
+    fragment->font = NULL;
+    fragment->font_cache = NULL;
+}
+
+static TTF_Text *NapysAcquireText(NapysRendererTTF *rdr, const NapysLayoutRun *run)
+{
+    if (rdr->free_texts_count > 0)
+    {
+        TTF_Text *text = rdr->free_texts[--rdr->free_texts_count];
+
+        if (TTF_SetTextFont(text, run->font) && TTF_SetTextString(text, run->text, run->length))
+        {
+            rdr->stats.fragments_reused++;
+            return text;
+        }
+
+        TTF_DestroyText(text);
+        rdr->stats.fragments_destroyed++;
+    }
+
+    rdr->stats.fragments_created++;
+
+    return TTF_CreateText(rdr->engine, run->font, run->text, run->length);
+}
+
+static bool NapysColorsEqual(SDL_Color a, SDL_Color b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+static bool NapysTextEquals(const TTF_Text *text, const NapysLayoutRun *run)
+{
+    return SDL_strncmp(text->text, run->text, run->length) == 0 && text->text[run->length] == '\0';
+}
+
+static bool NapysUpdateTextFragment(NapysFragmentTTF *fragment, const NapysLayoutRun *run)
+{
+    if (!NapysTextEquals(fragment->text, run))
+    {
+        if (!TTF_SetTextString(fragment->text, run->text, run->length))
+        {
+            return NapysSetError("Failed to update TTF_Text contents");
+        }
+    }
+
+    if (fragment->font != run->font)
+    {
+        if (!TTF_SetTextFont(fragment->text, run->font))
+        {
+            return NapysSetError("Failed to update TTF_Text font");
+        }
+
+        NapysReleaseCachedFont(fragment->font_cache, fragment->font);
+        NapysRetainCachedFont(run->font_cache, run->font);
+
+        fragment->font = run->font;
+        fragment->font_cache = run->font_cache;
+    }
+
+    if (!NapysColorsEqual(fragment->color, run->color))
+    {
+        TTF_SetTextColor(fragment->text, run->color.r, run->color.g, run->color.b, run->color.a);
+        fragment->color = run->color;
+    }
+
+    return true;
+}
+
+// Create or update the TTF_Text of a fragment to show the run
+static bool NapysSetFragmentText(NapysRendererTTF *rdr, NapysFragmentTTF *fragment, const NapysLayoutRun *run)
+{
+    // Reuse the text left in the fragment from the previous execution, updating only what has changed
+    if (fragment->text)
+    {
+        rdr->stats.fragments_reused++;
+        return NapysUpdateTextFragment(fragment, run);
+    }
+
+    TTF_Text *ttf_text = NapysAcquireText(rdr, run);
     if (!ttf_text)
     {
-        NapysSetError("Failed to create TTF_Text");
+        return NapysSetError("Failed to create TTF_Text");
+    }
+
+    TTF_SetTextColor(ttf_text, run->color.r, run->color.g, run->color.b, run->color.a);
+
+    fragment->text = ttf_text;
+    fragment->font = run->font;
+    fragment->font_cache = run->font_cache;
+    fragment->color = run->color;
+
+    NapysRetainCachedFont(fragment->font_cache, fragment->font);
+
+    return true;
+}
+
+static NapysFragmentTTF *NapysGetNextTextFragment(NapysRendererTTF *rdr, const NapysLayoutRun *run, int run_index)
+{
+    NapysFragmentTTF *fragment = NapysGetFragmentSlot(rdr);
+
+    if (!fragment)
+    {
         return NULL;
     }
 
-    TTF_SetTextColor(ttf_text, rdr->current_color.r, rdr->current_color.g, rdr->current_color.b, rdr->current_color.a);
+    if (rdr->lazy_texts)
+    {
+        // The text is set when the fragment is first rendered
+        fragment->pending = true;
+        fragment->run = run_index;
+    }
+    else
+    {
+        // SDL_ttf uses the font while creating and updating texts, which may be measured by other threads
+        NAPYS_PROFILE_BEGIN("NapysSetFragmentText", rdr);
+        NapysLockFontCache(run->font_cache);
+        const bool result = NapysSetFragmentText(rdr, fragment, run);
+        NapysUnlockFontCache(run->font_cache);
+        NAPYS_PROFILE_END("NapysSetFragmentText", rdr);
+
+        if (!result)
+        {
+            return NULL;
+        }
+
+        fragment->pending = false;
+    }
 
-    NapysFragmentTTF fragment = {0};
-    fragment.text = ttf_text;
-    fragment.img = NULL;
-    fragment.x = rdr->draw_x;
-    fragment.y = rdr->draw_y;
+    fragment->img = NULL;
+    fragment->x = run->x;
+    fragment->y = run->y;
+    fragment->w = run->w;
+    fragment->h = run->h;
 
-    rdr->fragments[rdr->fragments_count] = fragment;
+    if (rdr->fragment_pointer >= rdr->fragments_count)
+    {
+        rdr->fragments_count = rdr->fragment_pointer + 1;
+    }
 
-    rdr->fragments_count++;
     rdr->fragment_pointer++;
 
-    return &rdr->fragments[rdr->fragments_count - 1];
+    return fragment;
 }
 
-static NapysFragmentTTF *NapysGetNextImageFragment(NapysRendererTTF *rdr, SDL_Texture *img)
+static NapysFragmentTTF *NapysGetNextImageFragment(NapysRendererTTF *rdr, const NapysLayoutRun *run)
 {
-    if (rdr->fragment_pointer >= NAPYS_TTF_RENDERER_MAX_TEXTS)
+    NapysFragmentTTF *fragment = NapysGetFragmentSlot(rdr);
+
+    if (!fragment)
     {
-        NapysSetError("Maximum number of text fragments reached");
         return NULL;
     }
 
-    if (rdr->fragment_pointer < rdr->fragments_count)
+    // A text fragment in this slot is no longer needed
+    if (rdr->fragment_pointer < rdr->fragments_count && fragment->text)
     {
-        return &rdr->fragments[rdr->fragment_pointer++];
+        NapysReleaseTextFragment(rdr, fragment);
     }
 
-    NapysFragmentTTF fragment = {0};
-    fragment.text = NULL;
-    fragment.img = img;
-    fragment.x = rdr->draw_x;
-    fragment.y = rdr->draw_y;
+    fragment->img = (SDL_Texture *)run->img;
+    fragment->pending = false;
+    fragment->x = run->x;
+    fragment->y = run->y;
+    fragment->w = run->w;
+    fragment->h = run->h;
 
-    rdr->fragments[rdr->fragments_count] = fragment;
+    if (rdr->fragment_pointer >= rdr->fragments_count)
+    {
+        rdr->fragments_count = rdr->fragment_pointer + 1;
+    }
 
-    rdr->fragments_count++;
     rdr->fragment_pointer++;
 
-    return &rdr->fragments[rdr->fragments_count - 1];
+    return fragment;
 }
 
-static void NapysUpdateBounds(NapysRendererTTF *rdr, int x, int y, int width, int height)
+static void NapysReleaseUnusedFragments(NapysRendererTTF *rdr)
 {
-    if (x < rdr->bounds.x)
-        rdr->bounds.x = x;
-    if (y < rdr->bounds.y)
-        rdr->bounds.y = y;
-
-    const int end_x = x + width;
-    const int end_y = y + height;
-
-    if (end_x > rdr->bounds.x + rdr->bounds.w)
+    for (int i = rdr->fragment_pointer; i < rdr->fragments_count; i++)
     {
-        rdr->bounds.w += end_x - (rdr->bounds.x + rdr->bounds.w);
+        if (rdr->fragments[i].text)
+        {
+            NapysReleaseTextFragment(rdr, &rdr->fragments[i]);
+        }
+        SDL_memset(&rdr->fragments[i], 0, sizeof(NapysFragmentTTF));
     }
 
-    if (y + height > rdr->bounds.h + rdr->bounds.y)
+    rdr->fragments_count = rdr->fragment_pointer;
+}
+
+static int NapysCountGlyphs(const char *text, size_t length)
+{
+    int count = 0;
+
+    while (length > 0 && SDL_StepUTF8(&text, &length))
     {
-        rdr->bounds.h += end_y - (rdr->bounds.y + rdr->bounds.h);
+        count++;
     }
+
+    return count;
 }
 
-void NapysExecuteCommandList(NapysRendererTTF *rdr, NapysCommandList *list)
+static NapysLineTTF *NapysAddLineTTF(NapysRendererTTF *rdr)
 {
-    if (!rdr || !list)
+    if (rdr->lines_count >= rdr->lines_capacity)
     {
-        NapysSetError("Invalid renderer or command list");
-        return;
+        int new_capacity = rdr->lines_capacity == 0 ? 8 : rdr->lines_capacity * 2;
+        NapysLineTTF *new_lines = SDL_realloc(rdr->lines, new_capacity * sizeof(NapysLineTTF));
+
+        if (!new_lines)
+        {
+            NapysSetError("Failed to allocate memory for renderer lines");
+            return NULL;
+        }
+
+        rdr->stats.bytes_allocated += new_capacity * sizeof(NapysLineTTF);
+
+        rdr->lines = new_lines;
+        rdr->lines_capacity = new_capacity;
     }
 
-    NapysResetRendererTTF(rdr);
+    return &rdr->lines[rdr->lines_count++];
+}
 
-    NapysFragmentTTF *cur_fragment = NULL;
+// Bring the fragments and lines up to date with the layout, reusing the texts of the previous execution
+static void NapysBuildFragments(NapysRendererTTF *rdr, const NapysLayout *layout)
+{
+    rdr->fragment_pointer = 0;
+    rdr->lines_count = 0;
+    rdr->glyphs_count = 0;
+    rdr->cache_valid = false;
 
-    rdr->current_font = NapysQueryFontCache(rdr->ctx->default_font_cache, rdr->current_font_size);
+    // The revealed fragment may change, and its font may be closed by the font cache
+    if (rdr->reveal_text)
+    {
+        TTF_SetTextFont(rdr->reveal_text, NULL);
+        rdr->reveal_fragment = -1;
+    }
+
+    rdr->bounds = layout->bounds;
+    rdr->executed_layout = layout;
+    rdr->executed_strings_generation = rdr->ctx->strings_generation;
 
-    for (int ci = 0; ci < list->cmd_count; ci++)
+    for (int li = 0; li < layout->lines_count; li++)
     {
-        NapysCommand *cmd = &list->cmds[ci];
+        const NapysLayoutLine *layout_line = &layout->lines[li];
 
-        bool advance_position = false;
+        NapysLineTTF *line = NapysAddLineTTF(rdr);
 
-        if (cmd->type == NAPYS_COMMAND_TYPE_DRAW_TEXT)
+        if (!line)
         {
-            cur_fragment = NapysGetNextTextFragment(rdr, cmd->data);
-
-            advance_position = true;
+            break;
         }
-        else if (cmd->type == NAPYS_COMMAND_TYPE_SET_COLOR)
+
+        line->y = layout_line->y;
+        line->h = layout_line->h;
+        line->first_fragment = rdr->fragment_pointer;
+
+        for (int i = layout_line->first_run; i < layout_line->first_run + layout_line->runs_count; i++)
         {
-            NapysRegistryEntry *entry = (NapysRegistryEntry *)NapysHashmapGetPointer(rdr->ctx->registry, cmd->data);
+            const NapysLayoutRun *run = &layout->runs[i];
+            NapysFragmentTTF *fragment = NULL;
 
-            if (entry && entry->type == NAPYS_REGISTRY_ENTRY_COLOR)
+            if (run->type == NAPYS_LAYOUT_RUN_TEXT)
             {
-                rdr->current_color = entry->color;
+                fragment = NapysGetNextTextFragment(rdr, run, i);
             }
-        }
-        else if (cmd->type == NAPYS_COMMAND_TYPE_SET_FONT)
-        {
-            NapysFontCache *font_cache = (NapysFontCache *)NapysHashmapGetPointer(rdr->ctx->fonts, cmd->data);
-
-            if (font_cache && font_cache->base)
+            else if (run->img)
             {
-                TTF_Font *new_font = NapysQueryFontCache(font_cache, rdr->current_font_size);
-
-                if (new_font)
-                {
-                    rdr->current_font = new_font;
-                    rdr->current_font_cache = font_cache;
-                }
+                fragment = NapysGetNextImageFragment(rdr, run);
             }
-        }
-        else if (cmd->type == NAPYS_COMMAND_TYPE_SET_SIZE)
-        {
-            NapysRegistryEntry *entry = (NapysRegistryEntry *)NapysHashmapGetPointer(rdr->ctx->registry, cmd->data);
-            if (entry && entry->type == NAPYS_REGISTRY_ENTRY_SIZE)
+
+            if (fragment)
             {
-                rdr->current_font_size = entry->ptsize;
+                fragment->first_glyph = rdr->glyphs_count;
+                fragment->glyphs_count = fragment->img ? 1 : NapysCountGlyphs(run->text, run->length);
 
-                rdr->current_font = NapysQueryFontCache(rdr->current_font_cache, rdr->current_font_size);
+                rdr->glyphs_count += fragment->glyphs_count;
             }
         }
-        else if (cmd->type == NAPYS_COMMAND_TYPE_NEWLINE)
+
+        line->fragments_count = rdr->fragment_pointer - line->first_fragment;
+    }
+
+    NapysReleaseUnusedFragments(rdr);
+}
+
+void NapysExecuteCommandList(NapysRendererTTF *rdr, NapysCommandList *list)
+{
+    if (!rdr || !list)
+    {
+        NapysSetError("Invalid renderer or command list");
+        return;
+    }
+
+    NAPYS_PROFILE_BEGIN("NapysExecuteCommandList", rdr);
+    const Uint64 start = SDL_GetTicksNS();
+
+    // A failed layout keeps only the runs laid out before the failure
+    NapysLayoutCommandList(rdr->layout, list);
+
+    NapysBuildFragments(rdr, rdr->layout);
+
+    rdr->stats.execute_ns += SDL_GetTicksNS() - start;
+    NAPYS_PROFILE_END("NapysExecuteCommandList", rdr);
+}
+
+void NapysExecuteLayout(NapysRendererTTF *rdr, const NapysLayout *layout)
+{
+    if (!rdr || !layout)
+    {
+        NapysSetError("Invalid renderer or layout");
+        return;
+    }
+
+    NAPYS_PROFILE_BEGIN("NapysExecuteLayout", rdr);
+    const Uint64 start = SDL_GetTicksNS();
+
+    NapysBuildFragments(rdr, layout);
+
+    rdr->stats.execute_ns += SDL_GetTicksNS() - start;
+    NAPYS_PROFILE_END("NapysExecuteLayout", rdr);
+}
+
+// Draw the first glyphs of a text fragment with the reveal text, which is updated only when the reveal moves
+static void NapysRenderRevealedText(NapysRendererTTF *renderer, int index, float x, float y)
+{
+    NapysFragmentTTF *fragment = &renderer->fragments[index];
+
+    const char *full_text = fragment->text->text;
+    const char *end = full_text;
+    size_t left = SDL_strlen(full_text);
+
+    for (int i = fragment->first_glyph; i < renderer->revealed_glyphs && left > 0; i++)
+    {
+        SDL_StepUTF8(&end, &left);
+    }
+
+    const size_t length = (size_t)(end - full_text);
+
+    NapysLockFontCache(fragment->font_cache);
+
+    if (!renderer->reveal_text)
+    {
+        renderer->reveal_text = TTF_CreateText(renderer->engine, fragment->font, full_text, length);
+        renderer->stats.fragments_created++;
+
+        if (!renderer->reveal_text)
         {
-            rdr->draw_x = 0;
-            rdr->draw_y += TTF_GetFontHeight(rdr->current_font);
+            NapysUnlockFontCache(fragment->font_cache);
+            NapysSetError("Failed to create TTF_Text");
+            return;
         }
-        else if (cmd->type == NAPYS_COMMAND_TYPE_DRAW_IMAGE)
-        {
-            NapysRegistryEntry *entry = (NapysRegistryEntry *)NapysHashmapGetPointer(rdr->ctx->registry, cmd->data);
 
-            if (entry && entry->type == NAPYS_REGISTRY_ENTRY_IMAGE)
-            {
-                SDL_Texture *img = (SDL_Texture *)entry->img;
-                NapysFragmentTTF *img_fragment = NapysGetNextImageFragment(rdr, img);
+        renderer->reveal_fragment = -1;
+        renderer->reveal_length = length;
+    }
 
-                if (img_fragment)
-                {
-                    int line_height = TTF_GetFontHeight(rdr->current_font);
-                    float img_width, img_height;
-                    SDL_GetTextureSize(img, &img_width, &img_height);
+    if (renderer->reveal_fragment != index)
+    {
+        TTF_SetTextFont(renderer->reveal_text, fragment->font);
+        TTF_SetTextColor(renderer->reveal_text, fragment->color.r, fragment->color.g, fragment->color.b, fragment->color.a);
+        TTF_SetTextString(renderer->reveal_text, full_text, length);
+    }
+    else if (renderer->reveal_length != length)
+    {
+        TTF_SetTextString(renderer->reveal_text, full_text, length);
+    }
 
-                    img_fragment->x = rdr->draw_x;
-                    img_fragment->y = rdr->draw_y + line_height / 2 - img_height / 2;
+    renderer->reveal_fragment = index;
+    renderer->reveal_length = length;
 
-                    rdr->draw_x += img_width;
+    TTF_DrawRendererText(renderer->reveal_text, x + fragment->x, y + fragment->y);
+    renderer->stats.draw_calls++;
 
-                    NapysUpdateBounds(rdr, img_fragment->x, img_fragment->y, img_width, img_height);
-                }
-            }
+    NapysUnlockFontCache(fragment->font_cache);
+}
+
+static void NapysRenderFragment(NapysRendererTTF *renderer, int index, float x, float y)
+{
+    NapysFragmentTTF *fragment = &renderer->fragments[index];
+
+    float draw_x = x + fragment->x;
+    float draw_y = y + fragment->y;
+
+    const bool revealing = renderer->revealed_glyphs >= 0;
+
+    if (revealing && fragment->first_glyph >= renderer->revealed_glyphs)
+    {
+        return;
+    }
+
+    if (fragment->pending)
+    {
+        // Replacing a registered string released the text the runs of the executed layout point to
+        if (renderer->executed_strings_generation != renderer->ctx->strings_generation)
+        {
+            return;
         }
-        else if (cmd->type == NAPYS_COMMAND_TYPE_USE_STRING)
+
+        const NapysLayoutRun *run = &renderer->executed_layout->runs[fragment->run];
+
+        NAPYS_PROFILE_BEGIN("NapysSetFragmentText", renderer);
+        NapysLockFontCache(run->font_cache);
+        fragment->pending = !NapysSetFragmentText(renderer, fragment, run);
+        NapysUnlockFontCache(run->font_cache);
+        NAPYS_PROFILE_END("NapysSetFragmentText", renderer);
+
+        // A text that failed to update would show stale contents
+        if (fragment->pending)
         {
-            NapysRegistryEntry *entry = (NapysRegistryEntry *)NapysHashmapGetPointer(rdr->ctx->registry, cmd->data);
+            return;
+        }
+    }
 
-            if (entry && entry->type == NAPYS_REGISTRY_ENTRY_STRING)
-            {
-                cur_fragment = NapysGetNextTextFragment(rdr, entry->str);
+    if (revealing && fragment->text && fragment->first_glyph + fragment->glyphs_count > renderer->revealed_glyphs)
+    {
+        NapysRenderRevealedText(renderer, index, x, y);
+        return;
+    }
 
-                advance_position = true;
-            }
+    if (fragment->text)
+    {
+        NapysLockFontCache(fragment->font_cache);
+        TTF_DrawRendererText(fragment->text, draw_x, draw_y);
+        NapysUnlockFontCache(fragment->font_cache);
+
+        renderer->stats.draw_calls++;
+    }
+
+    if (fragment->img)
+    {
+        SDL_FRect img_rect = {draw_x, draw_y, fragment->w, fragment->h};
+        SDL_RenderTexture(renderer->sdl_renderer, fragment->img, NULL, &img_rect);
+        renderer->stats.draw_calls++;
+    }
+}
+
+static bool NapysBakeTextureCache(NapysRendererTTF *renderer)
+{
+    const SDL_Rect *bounds = &renderer->bounds;
+
+    if (renderer->cache_valid && renderer->cache_generation == renderer->ctx->generation)
+    {
+        return true;
+    }
+
+    if (!renderer->cache_texture || renderer->cache_texture->w != bounds->w || renderer->cache_texture->h != bounds->h)
+    {
+        if (renderer->cache_texture)
+        {
+            SDL_DestroyTexture(renderer->cache_texture);
         }
 
-        if (advance_position)
+        renderer->cache_texture = SDL_CreateTexture(renderer->sdl_renderer, SDL_PIXELFORMAT_ARGB8888,
+                                                    SDL_TEXTUREACCESS_TARGET, bounds->w, bounds->h);
+
+        if (!renderer->cache_texture)
         {
-            int text_width, text_height;
+            // Render targets are not supported, so stop trying and draw the fragments from now on
+            renderer->texture_cache = false;
+            return NapysSetError("Failed to create texture cache render target");
+        }
 
-            TTF_GetTextSize(cur_fragment->text, &text_width, &text_height);
+        // Blending onto a transparent target leaves the colors premultiplied by alpha
+        SDL_SetTextureBlendMode(renderer->cache_texture, SDL_BLENDMODE_BLEND_PREMULTIPLIED);
+    }
 
-            NapysUpdateBounds(rdr, rdr->draw_x, rdr->draw_y, text_width, text_height);
+    SDL_Texture *previous_target = SDL_GetRenderTarget(renderer->sdl_renderer);
+    Uint8 r, g, b, a;
+    SDL_GetRenderDrawColor(renderer->sdl_renderer, &r, &g, &b, &a);
 
-            rdr->draw_x += text_width;
-        }
+    SDL_SetRenderTarget(renderer->sdl_renderer, renderer->cache_texture);
+    SDL_SetRenderDrawColor(renderer->sdl_renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer->sdl_renderer);
+
+    for (int i = 0; i < renderer->fragments_count; i++)
+    {
+        NapysRenderFragment(renderer, i, (float)-bounds->x, (float)-bounds->y);
     }
+
+    SDL_SetRenderDrawColor(renderer->sdl_renderer, r, g, b, a);
+    SDL_SetRenderTarget(renderer->sdl_renderer, previous_target);
+
+    renderer->cache_valid = true;
+    renderer->cache_generation = renderer->ctx->generation;
+
+    return true;
 }
 
 void NapysRenderTTF(NapysRendererTTF *renderer, float x, float y)
@@ -261,28 +747,86 @@ void NapysRenderTTF(NapysRendererTTF *renderer, float x, float y)
         return;
     }
 
-    for (int i = 0; i <= renderer->fragment_pointer; i++)
+    NAPYS_PROFILE_BEGIN("NapysRenderTTF", renderer);
+    const Uint64 start = SDL_GetTicksNS();
+
+    // An empty output has nothing to bake, and a partially revealed one changes too often to be worth it
+    const bool revealed = renderer->revealed_glyphs < 0 || renderer->revealed_glyphs >= renderer->glyphs_count;
+
+    if (renderer->texture_cache && revealed && renderer->bounds.w > 0 && renderer->bounds.h > 0 &&
+        NapysBakeTextureCache(renderer))
+    {
+        const SDL_FRect rect = {x + renderer->bounds.x, y + renderer->bounds.y, (float)renderer->bounds.w,
+                                (float)renderer->bounds.h};
+        SDL_RenderTexture(renderer->sdl_renderer, renderer->cache_texture, NULL, &rect);
+        renderer->stats.draw_calls++;
+    }
+    else
     {
-        NapysFragmentTTF *fragment = &renderer->fragments[i];
+        for (int i = 0; i < renderer->fragments_count; i++)
+        {
+            NapysRenderFragment(renderer, i, x, y);
+        }
+    }
 
-        float draw_x = x + fragment->x;
-        float draw_y = y + fragment->y;
+    renderer->stats.render_ns += SDL_GetTicksNS() - start;
+    NAPYS_PROFILE_END("NapysRenderTTF", renderer);
+}
 
-        if (fragment)
+void NapysRenderTTFClipped(NapysRendererTTF *renderer, float x, float y, const SDL_Rect *clip)
+{
+    if (!renderer || !renderer->engine || !clip)
+    {
+        NapysSetError("Invalid renderer, text engine or clip rectangle");
+        return;
+    }
+
+    NAPYS_PROFILE_BEGIN("NapysRenderTTFClipped", renderer);
+    const Uint64 start = SDL_GetTicksNS();
+
+    // The clip rectangle relative to the layout origin
+    const float clip_left = clip->x - x;
+    const float clip_top = clip->y - y;
+    const float clip_right = clip_left + clip->w;
+    const float clip_bottom = clip_top + clip->h;
+
+    // Lines are sorted and do not overlap, so find the first one ending below the top of the clip rectangle
+    int low = 0;
+    int high = renderer->lines_count;
+
+    while (low < high)
+    {
+        const int middle = low + (high - low) / 2;
+        const NapysLineTTF *line = &renderer->lines[middle];
+
+        if (line->y + line->h <= clip_top)
         {
-            if (fragment->text)
-            {
-                TTF_DrawRendererText(fragment->text, draw_x, draw_y);
-            }
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
 
-            if (fragment->img)
+    for (int li = low; li < renderer->lines_count && renderer->lines[li].y < clip_bottom; li++)
+    {
+        const NapysLineTTF *line = &renderer->lines[li];
+
+        for (int i = line->first_fragment; i < line->first_fragment + line->fragments_count; i++)
+        {
+            NapysFragmentTTF *fragment = &renderer->fragments[i];
+
+            if (fragment->x < clip_right && fragment->x + fragment->w > clip_left && fragment->y < clip_bottom &&
+                fragment->y + fragment->h > clip_top)
             {
-                SDL_FRect img_rect = {draw_x, draw_y, 0, 0};
-                SDL_GetTextureSize(fragment->img, &img_rect.w, &img_rect.h);
-                SDL_RenderTexture(renderer->sdl_renderer, fragment->img, NULL, &img_rect);
+                NapysRenderFragment(renderer, i, x, y);
             }
         }
     }
+
+    renderer->stats.render_ns += SDL_GetTicksNS() - start;
+    NAPYS_PROFILE_END("NapysRenderTTFClipped", renderer);
 }
 
 bool NapysGetRenderedTextBounds(NapysRendererTTF *renderer, SDL_Rect *output)
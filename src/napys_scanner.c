@@ -0,0 +1,184 @@
+#include <napys.h>
+#include "napys_internal.h"
+
+#include <SDL3/SDL_intrin.h>
+
+/*
+ * Delimiter scanning for the rich-text parser.
+ *
+ * The parser only needs to stop on two bytes: the first byte of a tag delimiter and, optionally, a newline.
+ * Everything in between is plain text, so it is skipped a whole vector register at a time.
+ * The best implementation supported by the CPU is picked on first use, with a scalar fallback.
+ */
+
+typedef const char *(*NapysFindDelimiterFunc)(const char *cursor, const char *end, char first, char second);
+
+static int NapysLowestBitIndex(Uint32 mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask);
+#else
+    int index = 0;
+    while ((mask & 1) == 0)
+    {
+        mask >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+const char *NapysFindDelimiterScalar(const char *cursor, const char *end, char first, char second)
+{
+    while (cursor < end)
+    {
+        if (*cursor == first || *cursor == second)
+        {
+            return cursor;
+        }
+        cursor++;
+    }
+
+    return end;
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+static const char *SDL_TARGETING("sse2") NapysFindDelimiterSSE2(const char *cursor, const char *end, char first, char second)
+{
+    const __m128i first_v = _mm_set1_epi8(first);
+    const __m128i second_v = _mm_set1_epi8(second);
+
+    while (end - cursor >= 16)
+    {
+        const __m128i block = _mm_loadu_si128((const __m128i *)cursor);
+        const __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(block, first_v), _mm_cmpeq_epi8(block, second_v));
+        const Uint32 mask = (Uint32)_mm_movemask_epi8(matches);
+
+        if (mask)
+        {
+            return cursor + NapysLowestBitIndex(mask);
+        }
+
+        cursor += 16;
+    }
+
+    return NapysFindDelimiterScalar(cursor, end, first, second);
+}
+#endif
+
+#ifdef SDL_AVX2_INTRINSICS
+static const char *SDL_TARGETING("avx2") NapysFindDelimiterAVX2(const char *cursor, const char *end, char first, char second)
+{
+    const __m256i first_v = _mm256_set1_epi8(first);
+    const __m256i second_v = _mm256_set1_epi8(second);
+
+    while (end - cursor >= 32)
+    {
+        const __m256i block = _mm256_loadu_si256((const __m256i *)cursor);
+        const __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi8(block, first_v), _mm256_cmpeq_epi8(block, second_v));
+        const Uint32 mask = (Uint32)_mm256_movemask_epi8(matches);
+
+        if (mask)
+        {
+            return cursor + NapysLowestBitIndex(mask);
+        }
+
+        cursor += 32;
+    }
+
+    return NapysFindDelimiterScalar(cursor, end, first, second);
+}
+#endif
+
+#ifdef SDL_NEON_INTRINSICS
+static const char *NapysFindDelimiterNEON(const char *cursor, const char *end, char first, char second)
+{
+    const uint8x16_t first_v = vdupq_n_u8((Uint8)first);
+    const uint8x16_t second_v = vdupq_n_u8((Uint8)second);
+
+    while (end - cursor >= 16)
+    {
+        const uint8x16_t block = vld1q_u8((const Uint8 *)cursor);
+        const uint8x16_t matches = vorrq_u8(vceqq_u8(block, first_v), vceqq_u8(block, second_v));
+
+        // Narrow every matching byte to 4 bits of a 64-bit mask
+        const Uint64 mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+
+        if (mask)
+        {
+            const Uint32 low = (Uint32)mask;
+            const int bit = low ? NapysLowestBitIndex(low) : 32 + NapysLowestBitIndex((Uint32)(mask >> 32));
+            return cursor + bit / 4;
+        }
+
+        cursor += 16;
+    }
+
+    return NapysFindDelimiterScalar(cursor, end, first, second);
+}
+#endif
+
+static NapysFindDelimiterFunc NapysSelectFindDelimiter()
+{
+#ifdef SDL_AVX2_INTRINSICS
+    if (SDL_HasAVX2())
+    {
+        return NapysFindDelimiterAVX2;
+    }
+#endif
+
+#ifdef SDL_SSE2_INTRINSICS
+    if (SDL_HasSSE2())
+    {
+        return NapysFindDelimiterSSE2;
+    }
+#endif
+
+#ifdef SDL_NEON_INTRINSICS
+    if (SDL_HasNEON())
+    {
+        return NapysFindDelimiterNEON;
+    }
+#endif
+
+    return NapysFindDelimiterScalar;
+}
+
+// Stored as an atomic pointer, as parsers may run on several threads at once
+static void *napys_find_delimiter = NULL;
+
+const char *NapysFindDelimiter(const char *cursor, const char *end, char first, char second)
+{
+    NapysFindDelimiterFunc func = (NapysFindDelimiterFunc)SDL_GetAtomicPointer(&napys_find_delimiter);
+
+    // Selection always gives the same result, so racing threads can only store the same pointer
+    if (!func)
+    {
+        func = NapysSelectFindDelimiter();
+        SDL_SetAtomicPointer(&napys_find_delimiter, (void *)func);
+    }
+
+    return func(cursor, end, first, second);
+}
+
+const char *NapysFindString(const char *cursor, const char *end, const char *needle, size_t needle_length)
+{
+    while (cursor < end)
+    {
+        cursor = NapysFindDelimiter(cursor, end, needle[0], needle[0]);
+
+        if ((size_t)(end - cursor) < needle_length)
+        {
+            return NULL;
+        }
+
+        if (SDL_memcmp(cursor, needle, needle_length) == 0)
+        {
+            return cursor;
+        }
+
+        cursor++;
+    }
+
+    return NULL;
+}
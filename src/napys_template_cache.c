@@ -0,0 +1,362 @@
+#include <napys.h>
+#include "napys_internal.h"
+
+typedef struct NapysTemplateEntry
+{
+    Uint32 hash;
+
+    const char *text;
+    size_t text_length;
+
+    const char *left_tag;
+    const char *right_tag;
+    bool treat_newline_chars_as_commands;
+
+    NapysCommandList *list;
+
+    struct NapysTemplateEntry *bucket_next;
+    struct NapysTemplateEntry *lru_prev;
+    struct NapysTemplateEntry *lru_next;
+} NapysTemplateEntry;
+
+struct NapysTemplateCache
+{
+    NapysTemplateEntry **buckets;
+    Uint32 bucket_mask;
+
+    NapysTemplateEntry *lru_head; // Most recently used
+    NapysTemplateEntry *lru_tail; // Least recently used
+
+    int entries;
+    int capacity;
+
+    Uint64 hits;
+    Uint64 misses;
+
+    SDL_Mutex *lock;
+};
+
+static Uint32 NapysHashTemplate(const char *text, size_t text_length, const char *left_tag, const char *right_tag, bool newlines)
+{
+    Uint32 seed = newlines ? 0x9e3779b9u : 0;
+
+    seed = SDL_murmur3_32(left_tag, SDL_strlen(left_tag), seed);
+    seed = SDL_murmur3_32(right_tag, SDL_strlen(right_tag), seed);
+
+    return SDL_murmur3_32(text, text_length, seed);
+}
+
+static bool NapysTemplateMatches(const NapysTemplateEntry *entry, Uint32 hash, const char *text, size_t text_length,
+                                 const char *left_tag, const char *right_tag, bool newlines)
+{
+    return entry->hash == hash &&
+           entry->text_length == text_length &&
+           entry->treat_newline_chars_as_commands == newlines &&
+           SDL_strcmp(entry->left_tag, left_tag) == 0 &&
+           SDL_strcmp(entry->right_tag, right_tag) == 0 &&
+           SDL_memcmp(entry->text, text, text_length) == 0;
+}
+
+static void NapysUnlinkTemplateLRU(NapysTemplateCache *cache, NapysTemplateEntry *entry)
+{
+    if (entry->lru_prev)
+        entry->lru_prev->lru_next = entry->lru_next;
+    else
+        cache->lru_head = entry->lru_next;
+
+    if (entry->lru_next)
+        entry->lru_next->lru_prev = entry->lru_prev;
+    else
+        cache->lru_tail = entry->lru_prev;
+
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void NapysPushTemplateLRU(NapysTemplateCache *cache, NapysTemplateEntry *entry)
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+
+    if (cache->lru_head)
+        cache->lru_head->lru_prev = entry;
+    else
+        cache->lru_tail = entry;
+
+    cache->lru_head = entry;
+}
+
+static void NapysEvictTemplate(NapysTemplateCache *cache, NapysTemplateEntry *entry)
+{
+    NapysTemplateEntry **link = &cache->buckets[entry->hash & cache->bucket_mask];
+
+    while (*link && *link != entry)
+    {
+        link = &(*link)->bucket_next;
+    }
+
+    if (*link)
+    {
+        *link = entry->bucket_next;
+    }
+
+    NapysUnlinkTemplateLRU(cache, entry);
+
+    // Callers may still hold the list, it is freed when the last of them releases it
+    NapysDestroyCommandList(entry->list);
+    SDL_free(entry);
+
+    cache->entries--;
+}
+
+// Find a cached list and take a reference to it for the caller, must be called with the cache locked
+static NapysCommandList *NapysLookupTemplate(NapysTemplateCache *cache, Uint32 hash, const char *text, size_t text_length,
+                                             const char *left_tag, const char *right_tag, bool newlines)
+{
+    for (NapysTemplateEntry *entry = cache->buckets[hash & cache->bucket_mask]; entry; entry = entry->bucket_next)
+    {
+        if (NapysTemplateMatches(entry, hash, text, text_length, left_tag, right_tag, newlines))
+        {
+            NapysUnlinkTemplateLRU(cache, entry);
+            NapysPushTemplateLRU(cache, entry);
+
+            SDL_AddAtomicInt(&entry->list->refcount, 1);
+            return entry->list;
+        }
+    }
+
+    return NULL;
+}
+
+void NapysDestroyTemplateCache(NapysTemplateCache *cache)
+{
+    if (cache)
+    {
+        while (cache->lru_head)
+        {
+            NapysEvictTemplate(cache, cache->lru_head);
+        }
+
+        SDL_DestroyMutex(cache->lock);
+        SDL_free(cache->buckets);
+        SDL_free(cache);
+    }
+}
+
+bool NapysSetTemplateCacheCapacity(NapysContext *ctx, int capacity)
+{
+    if (!ctx || capacity < 0)
+    {
+        return NapysSetError("Invalid context or template cache capacity");
+    }
+
+    if (capacity == 0)
+    {
+        NapysDestroyTemplateCache(ctx->template_cache);
+        ctx->template_cache = NULL;
+        return true;
+    }
+
+    NapysTemplateCache *cache = ctx->template_cache;
+
+    if (!cache)
+    {
+        cache = SDL_calloc(1, sizeof(NapysTemplateCache));
+        if (!cache)
+        {
+            return NapysSetError("Failed to allocate memory for template cache");
+        }
+
+        cache->lock = SDL_CreateMutex();
+        if (!cache->lock)
+        {
+            SDL_free(cache);
+            return NapysSetError("Failed to create template cache lock");
+        }
+    }
+
+    // Keep the chains short: at least two buckets per entry
+    Uint32 bucket_count = 16;
+    while (bucket_count < (Uint32)capacity * 2)
+    {
+        bucket_count *= 2;
+    }
+
+    NapysTemplateEntry **buckets = SDL_calloc(bucket_count, sizeof(NapysTemplateEntry *));
+    if (!buckets)
+    {
+        if (!ctx->template_cache)
+        {
+            SDL_DestroyMutex(cache->lock);
+            SDL_free(cache);
+        }
+        return NapysSetError("Failed to allocate memory for template cache");
+    }
+
+    SDL_LockMutex(cache->lock);
+
+    // Rehash existing entries into the new buckets
+    SDL_free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucket_mask = bucket_count - 1;
+
+    for (NapysTemplateEntry *entry = cache->lru_head; entry; entry = entry->lru_next)
+    {
+        NapysTemplateEntry **bucket = &cache->buckets[entry->hash & cache->bucket_mask];
+        entry->bucket_next = *bucket;
+        *bucket = entry;
+    }
+
+    cache->capacity = capacity;
+
+    while (cache->entries > cache->capacity)
+    {
+        NapysEvictTemplate(cache, cache->lru_tail);
+    }
+
+    SDL_UnlockMutex(cache->lock);
+
+    ctx->template_cache = cache;
+
+    return true;
+}
+
+NapysCommandList *NapysParseRichTextCached(NapysContext *ctx, const char *text, const NapysRichTextOptions *options)
+{
+    if (!ctx || !text)
+    {
+        NapysSetError("Invalid context or rich text");
+        return NULL;
+    }
+
+    NapysTemplateCache *cache = ctx->template_cache;
+
+    if (!cache)
+    {
+        return NapysParseRichText(text, options);
+    }
+
+    const char *left_tag = options && options->left_tag ? options->left_tag : "{{";
+    const char *right_tag = options && options->right_tag ? options->right_tag : "}}";
+    const bool newlines = options ? options->treat_newline_chars_as_commands : false;
+
+    const size_t text_length = SDL_strlen(text);
+    const Uint32 hash = NapysHashTemplate(text, text_length, left_tag, right_tag, newlines);
+
+    SDL_LockMutex(cache->lock);
+
+    NapysCommandList *cached = NapysLookupTemplate(cache, hash, text, text_length, left_tag, right_tag, newlines);
+
+    if (cached)
+    {
+        cache->hits++;
+        SDL_UnlockMutex(cache->lock);
+        return cached;
+    }
+
+    cache->misses++;
+
+    SDL_UnlockMutex(cache->lock);
+
+    // Parse outside of the lock, so other threads can use the cache in the meantime
+    const Uint64 start = SDL_GetTicksNS();
+    NapysCommandList *list = NapysParseRichText(text, options);
+
+    const NapysContextStats stats = {.parse_ns = SDL_GetTicksNS() - start};
+    NapysAddContextStats(ctx, &stats);
+
+    if (!list)
+    {
+        return NULL;
+    }
+
+    // The key strings are stored right after the entry, in the same allocation
+    const size_t lt_size = SDL_strlen(left_tag) + 1;
+    const size_t rt_size = SDL_strlen(right_tag) + 1;
+
+    NapysTemplateEntry *entry = SDL_malloc(sizeof(NapysTemplateEntry) + text_length + 1 + lt_size + rt_size);
+
+    if (!entry)
+    {
+        // Still a valid result, just not cached, but immutable like every list returned by the cache
+        list->immutable = true;
+        return list;
+    }
+
+    char *key_text = (char *)(entry + 1);
+    char *key_left_tag = key_text + text_length + 1;
+    char *key_right_tag = key_left_tag + lt_size;
+
+    SDL_memcpy(key_text, text, text_length + 1);
+    SDL_memcpy(key_left_tag, left_tag, lt_size);
+    SDL_memcpy(key_right_tag, right_tag, rt_size);
+
+    entry->hash = hash;
+    entry->text = key_text;
+    entry->text_length = text_length;
+    entry->left_tag = key_left_tag;
+    entry->right_tag = key_right_tag;
+    entry->treat_newline_chars_as_commands = newlines;
+
+    SDL_LockMutex(cache->lock);
+
+    // Another thread may have parsed and cached the same text in the meantime
+    cached = NapysLookupTemplate(cache, hash, text, text_length, left_tag, right_tag, newlines);
+
+    if (cached)
+    {
+        SDL_UnlockMutex(cache->lock);
+
+        SDL_free(entry);
+        NapysDestroyCommandList(list);
+
+        return cached;
+    }
+
+    list->immutable = true;
+    SDL_AddAtomicInt(&list->refcount, 1); // One reference for the cache, one for the caller
+    entry->list = list;
+
+    if (cache->entries >= cache->capacity)
+    {
+        NapysEvictTemplate(cache, cache->lru_tail);
+    }
+
+    NapysTemplateEntry **bucket = &cache->buckets[hash & cache->bucket_mask];
+    entry->bucket_next = *bucket;
+    *bucket = entry;
+
+    NapysPushTemplateLRU(cache, entry);
+    cache->entries++;
+
+    SDL_UnlockMutex(cache->lock);
+
+    return list;
+}
+
+bool NapysGetTemplateCacheStats(NapysContext *ctx, NapysTemplateCacheStats *stats)
+{
+    if (!ctx || !stats)
+    {
+        return NapysSetError("Invalid context or stats");
+    }
+
+    NapysTemplateCache *cache = ctx->template_cache;
+
+    if (cache)
+    {
+        SDL_LockMutex(cache->lock);
+    }
+
+    stats->hits = cache ? cache->hits : 0;
+    stats->misses = cache ? cache->misses : 0;
+    stats->entries = cache ? cache->entries : 0;
+    stats->capacity = cache ? cache->capacity : 0;
+
+    if (cache)
+    {
+        SDL_UnlockMutex(cache->lock);
+    }
+
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef NAPYS_TEST_H
+#define NAPYS_TEST_H
+
+#include <SDL3/SDL.h>
+
+#include <napys.h>
+
+/**
+ * Minimal headless test harness shared by the Napys tests.
+ *
+ * Every test is a function returning true when all of its checks pass. A failed check logs its location
+ * and the last Napys error, and returns false from the test.
+ */
+
+#define NAPYS_CHECK(condition)                                                                  \
+    do                                                                                          \
+    {                                                                                           \
+        if (!(condition))                                                                       \
+        {                                                                                       \
+            SDL_Log("%s:%d: check failed: %s (last error: %s)", __FILE__, __LINE__, #condition, \
+                    NapysGetError());                                                           \
+            return false;                                                                       \
+        }                                                                                       \
+    } while (0)
+
+typedef bool (*NapysTestFunc)(void);
+
+typedef struct
+{
+    const char *name;
+    NapysTestFunc func;
+} NapysTest;
+
+#define NAPYS_TEST(func) {#func, func}
+
+static int NapysRunTests(const NapysTest *tests, int count)
+{
+    int failures = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        const bool passed = tests[i].func();
+
+        SDL_Log("%s %s", passed ? "PASS" : "FAIL", tests[i].name);
+
+        if (!passed)
+        {
+            failures++;
+        }
+    }
+
+    SDL_Log("%d of %d tests passed", count - failures, count);
+
+    return failures == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,250 @@
+#include "napys_test.h"
+
+// Word offsets into a pack, see the layout described in napys_command_pack.c
+#define PACK_HEADER_WORDS 5
+#define PACK_LIST_WORDS 3
+#define PACK_COMMAND_WORDS 2
+
+// Words are used as storage, so packs written into it are aligned for NapysLoadCommandLists()
+static Uint32 pack_data[1024];
+static size_t pack_size;
+
+static Uint32 corrupt_data[1024];
+
+static const char *const list_names[] = {"menu/start", "dialogue/intro", "empty"};
+
+/**
+ * Parse the test lists and save them into pack_data.
+ */
+static bool WriteTestPack(void)
+{
+    NapysCommandList *lists[3] = {
+        NapysParseRichText("{{color:red}}Start{{:newline}}{{player}}", NULL),
+        NapysParseRichText("Hello {{size:big}}traveller", NULL),
+        NapysCreateCommandList(),
+    };
+
+    SDL_IOStream *dst = SDL_IOFromMem(pack_data, sizeof(pack_data));
+    bool saved = lists[0] && lists[1] && lists[2] && dst && NapysSaveCommandLists(dst, lists, list_names, 3);
+
+    pack_size = dst ? (size_t)SDL_TellIO(dst) : 0;
+
+    SDL_CloseIO(dst);
+
+    for (int i = 0; i < 3; i++)
+    {
+        NapysDestroyCommandList(lists[i]);
+    }
+
+    return saved;
+}
+
+/**
+ * Try to load a copy of the test pack with one word replaced.
+ */
+static bool LoadCorruptedPack(NapysContext *ctx, size_t word, Uint32 value)
+{
+    SDL_memcpy(corrupt_data, pack_data, pack_size);
+    corrupt_data[word] = SDL_Swap32LE(value);
+
+    NapysCommandPack *pack = NapysLoadCommandLists(ctx, corrupt_data, pack_size);
+    NapysDestroyCommandPack(pack);
+
+    return pack != NULL;
+}
+
+static Uint32 ReadPackWord(size_t word)
+{
+    return SDL_Swap32LE(pack_data[word]);
+}
+
+static bool TestRoundTrip(void)
+{
+    NAPYS_CHECK(WriteTestPack());
+
+    NapysContext *ctx = NapysCreateContext();
+    NAPYS_CHECK(ctx);
+
+    NapysCommandPack *pack = NapysLoadCommandLists(ctx, pack_data, pack_size);
+
+    NAPYS_CHECK(pack);
+    NAPYS_CHECK(NapysGetCommandPackSize(pack) == 3);
+
+    // Lists are sorted by name
+    const char *name = NULL;
+    NAPYS_CHECK(NapysGetCommandPackList(pack, 0, &name) && SDL_strcmp(name, "dialogue/intro") == 0);
+    NAPYS_CHECK(NapysGetCommandPackList(pack, 1, &name) && SDL_strcmp(name, "empty") == 0);
+    NAPYS_CHECK(NapysGetCommandPackList(pack, 2, &name) && SDL_strcmp(name, "menu/start") == 0);
+    NAPYS_CHECK(!NapysGetCommandPackList(pack, 3, NULL));
+
+    NapysCommandList *start = NapysFindCommandPackList(pack, "menu/start");
+
+    NAPYS_CHECK(start);
+    NAPYS_CHECK(start->immutable);
+    NAPYS_CHECK(start->cmd_count == 4);
+    NAPYS_CHECK(start->cmds[0].type == NAPYS_COMMAND_TYPE_SET_COLOR && SDL_strcmp(start->cmds[0].data, "red") == 0);
+    NAPYS_CHECK(start->cmds[1].type == NAPYS_COMMAND_TYPE_DRAW_TEXT && SDL_strcmp(start->cmds[1].data, "Start") == 0);
+    NAPYS_CHECK(start->cmds[2].type == NAPYS_COMMAND_TYPE_NEWLINE && start->cmds[2].data == NULL);
+    NAPYS_CHECK(start->cmds[3].type == NAPYS_COMMAND_TYPE_USE_STRING && SDL_strcmp(start->cmds[3].data, "player") == 0);
+
+    NAPYS_CHECK(NapysFindCommandPackList(pack, "empty")->cmd_count == 0);
+    NAPYS_CHECK(NapysFindCommandPackList(pack, "dialogue/intro")->cmd_count == 3);
+    NAPYS_CHECK(!NapysFindCommandPackList(pack, "menu"));
+
+    // Pack lists cannot be changed, and are freed only with their pack
+    NAPYS_CHECK(!NapysAddDrawTextCommand(start, "more"));
+    NapysClearCommandList(start);
+    NapysDestroyCommandList(start);
+    NAPYS_CHECK(start->cmd_count == 4);
+
+    NapysDestroyCommandPack(pack);
+    NapysDestroyContext(ctx);
+
+    return true;
+}
+
+static bool TestContextBinding(void)
+{
+    NAPYS_CHECK(WriteTestPack());
+
+    NapysContext *ctx = NapysCreateContext();
+    NapysContext *other = NapysCreateContext();
+
+    NAPYS_CHECK(ctx && other);
+    NAPYS_CHECK(NapysRegisterColor(ctx, "red", (SDL_Color){255, 0, 0, 255}));
+
+    NapysCommandPack *pack = NapysLoadCommandLists(ctx, pack_data, pack_size);
+    NAPYS_CHECK(pack);
+
+    NapysCommandList *start = NapysFindCommandPackList(pack, "menu/start");
+
+    NAPYS_CHECK(NapysCompileCommandList(ctx, start));
+    NAPYS_CHECK(start->cmds[0].resolved != NULL);
+
+    // Compiling against another context would overwrite the resolution used by the first one
+    NAPYS_CHECK(!NapysCompileCommandList(other, start));
+    NAPYS_CHECK(start->compiled_ctx == ctx);
+    NAPYS_CHECK(start->cmds[0].resolved != NULL);
+
+    NapysDestroyCommandPack(pack);
+    NapysDestroyContext(other);
+    NapysDestroyContext(ctx);
+
+    return true;
+}
+
+static bool TestRejectInvalidPacks(void)
+{
+    NAPYS_CHECK(WriteTestPack());
+
+    NapysContext *ctx = NapysCreateContext();
+    NAPYS_CHECK(ctx);
+
+    const Uint32 lists_count = ReadPackWord(2);
+    const Uint32 commands_count = ReadPackWord(3);
+    const Uint32 strings_size = ReadPackWord(4);
+    const size_t commands_word = PACK_HEADER_WORDS + lists_count * PACK_LIST_WORDS;
+
+    // Truncated and unaligned data
+    NAPYS_CHECK(!NapysLoadCommandLists(ctx, pack_data, pack_size - 1));
+    NAPYS_CHECK(!NapysLoadCommandLists(ctx, pack_data, PACK_HEADER_WORDS * sizeof(Uint32) - 1));
+    NAPYS_CHECK(!NapysLoadCommandLists(ctx, (const Uint8 *)pack_data + 1, pack_size - 1));
+    NAPYS_CHECK(!NapysLoadCommandLists(NULL, pack_data, pack_size));
+
+    // Header
+    NAPYS_CHECK(!LoadCorruptedPack(ctx, 0, 0));
+    NAPYS_CHECK(!LoadCorruptedPack(ctx, 1, NAPYS_COMMAND_PACK_VERSION + 1));
+    NAPYS_CHECK(!LoadCorruptedPack(ctx, 3, commands_count + 1));
+    NAPYS_CHECK(!LoadCorruptedPack(ctx, 4, strings_size + 1));
+
+    // Unsorted names, by swapping the name offsets of the first two lists
+    SDL_memcpy(corrupt_data, pack_data, pack_size);
+    corrupt_data[PACK_HEADER_WORDS] = pack_data[PACK_HEADER_WORDS + PACK_LIST_WORDS];
+    corrupt_data[PACK_HEADER_WORDS + PACK_LIST_WORDS] = pack_data[PACK_HEADER_WORDS];
+    NAPYS_CHECK(!NapysLoadCommandLists(ctx, corrupt_data, pack_size));
+
+    // Out of range offsets of a list
+    NAPYS_CHECK(!LoadCorruptedPack(ctx, PACK_HEADER_WORDS, strings_size));
+    NAPYS_CHECK(!LoadCorruptedPack(ctx, PACK_HEADER_WORDS + 1, commands_count + 1));
+    NAPYS_CHECK(!LoadCorruptedPack(ctx, PACK_HEADER_WORDS + 2, commands_count + 1));
+
+    // Out of range command type and data offset
+    NAPYS_CHECK(!LoadCorruptedPack(ctx, commands_word, NAPYS_COMMAND_TYPE_SET_ALIGN + 1));
+    NAPYS_CHECK(!LoadCorruptedPack(ctx, commands_word + 1, strings_size));
+
+    // Commands reading their data must have it, e.g. a color command without a name
+    NAPYS_CHECK(ReadPackWord(commands_word) != NAPYS_COMMAND_TYPE_NEWLINE);
+    NAPYS_CHECK(!LoadCorruptedPack(ctx, commands_word + 1, 0xFFFFFFFFu));
+
+    // Unterminated string table
+    SDL_memcpy(corrupt_data, pack_data, pack_size);
+    ((char *)corrupt_data)[pack_size - 1] = 'x';
+    NAPYS_CHECK(!NapysLoadCommandLists(ctx, corrupt_data, pack_size));
+
+    // The unmodified pack still loads
+    NAPYS_CHECK(LoadCorruptedPack(ctx, 0, ReadPackWord(0)));
+
+    NapysDestroyContext(ctx);
+
+    return true;
+}
+
+static bool TestRejectDuplicateNames(void)
+{
+    NapysCommandList *list = NapysCreateCommandList();
+    NAPYS_CHECK(list);
+
+    NapysCommandList *lists[] = {list, list};
+    const char *names[] = {"same", "same"};
+
+    SDL_IOStream *dst = SDL_IOFromMem(corrupt_data, sizeof(corrupt_data));
+    NAPYS_CHECK(dst);
+
+    const bool saved = NapysSaveCommandLists(dst, lists, names, 2);
+
+    SDL_CloseIO(dst);
+    NapysDestroyCommandList(list);
+
+    NAPYS_CHECK(!saved);
+
+    return true;
+}
+
+static bool TestRejectCommandsWithoutData(void)
+{
+    NapysCommandList *list = NapysCreateCommandList();
+    NAPYS_CHECK(list);
+
+    NAPYS_CHECK(NapysAddCommand(list, (NapysCommand){NAPYS_COMMAND_TYPE_NEWLINE, NULL, NULL}));
+
+    SDL_IOStream *dst = SDL_IOFromMem(corrupt_data, sizeof(corrupt_data));
+    NAPYS_CHECK(dst);
+
+    const char *name = "list";
+    const bool newline_saved = NapysSaveCommandLists(dst, &list, &name, 1);
+
+    NAPYS_CHECK(NapysAddCommand(list, (NapysCommand){NAPYS_COMMAND_TYPE_SET_ALIGN, NULL, NULL}));
+
+    const bool align_saved = NapysSaveCommandLists(dst, &list, &name, 1);
+
+    SDL_CloseIO(dst);
+    NapysDestroyCommandList(list);
+
+    NAPYS_CHECK(newline_saved);
+    NAPYS_CHECK(!align_saved);
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const NapysTest tests[] = {
+        NAPYS_TEST(TestRoundTrip),
+        NAPYS_TEST(TestContextBinding),
+        NAPYS_TEST(TestRejectInvalidPacks),
+        NAPYS_TEST(TestRejectDuplicateNames),
+        NAPYS_TEST(TestRejectCommandsWithoutData),
+    };
+
+    return NapysRunTests(tests, SDL_arraysize(tests));
+}
@@ -0,0 +1,147 @@
+#include "napys_test.h"
+#include "napys_internal.h"
+
+#define HASHMAP_TEST_KEYS 5000
+
+static bool TestInsertAndFind(void)
+{
+    NapysHashmap *map = NapysCreateHashmap(sizeof(int));
+
+    NAPYS_CHECK(map);
+    NAPYS_CHECK(map->count == 0);
+    NAPYS_CHECK(!NapysHashmapFind(map, "missing"));
+
+    bool inserted = false;
+    int *value = NapysHashmapInsert(map, "one", &inserted);
+
+    NAPYS_CHECK(value && inserted);
+    *value = 1;
+
+    value = NapysHashmapFind(map, "one");
+
+    NAPYS_CHECK(value && *value == 1);
+    NAPYS_CHECK(!NapysHashmapFind(map, "on"));
+    NAPYS_CHECK(!NapysHashmapFind(map, "one "));
+    NAPYS_CHECK(map->count == 1);
+
+    NapysDestroyHashmap(map);
+
+    return true;
+}
+
+static bool TestReplace(void)
+{
+    NapysHashmap *map = NapysCreateHashmap(sizeof(int));
+
+    NAPYS_CHECK(map);
+
+    bool inserted = false;
+    int *value = NapysHashmapInsert(map, "key", &inserted);
+
+    NAPYS_CHECK(value && inserted);
+    *value = 7;
+
+    // Inserting an existing key returns its slot with the value intact, so the caller can replace it
+    value = NapysHashmapInsert(map, "key", &inserted);
+
+    NAPYS_CHECK(value && !inserted);
+    NAPYS_CHECK(*value == 7);
+    NAPYS_CHECK(map->count == 1);
+
+    *value = 8;
+
+    value = NapysHashmapFind(map, "key");
+    NAPYS_CHECK(value && *value == 8);
+
+    NapysDestroyHashmap(map);
+
+    NapysHashmap *pointers = NapysCreateHashmap(sizeof(void *));
+
+    NAPYS_CHECK(pointers);
+
+    int first = 0;
+    int second = 0;
+
+    NapysHashmapStorePointer(pointers, "ptr", &first);
+    NapysHashmapStorePointer(pointers, "ptr", &second);
+
+    NAPYS_CHECK(NapysHashmapGetPointer(pointers, "ptr") == &second);
+    NAPYS_CHECK(!NapysHashmapGetPointer(pointers, "missing"));
+    NAPYS_CHECK(pointers->count == 1);
+
+    NapysDestroyHashmap(pointers);
+
+    return true;
+}
+
+static void CountEntry(const char *key, void *value, void *userdata)
+{
+    int *sum = (int *)userdata;
+
+    sum[0]++;
+    sum[1] += *(int *)value;
+}
+
+static bool TestResize(void)
+{
+    NapysHashmap *map = NapysCreateHashmap(sizeof(int));
+
+    NAPYS_CHECK(map);
+
+    const Uint32 initial_capacity = map->capacity;
+    char key[32];
+
+    for (int i = 0; i < HASHMAP_TEST_KEYS; i++)
+    {
+        SDL_snprintf(key, sizeof(key), "key%d", i);
+
+        bool inserted = false;
+        int *value = NapysHashmapInsert(map, key, &inserted);
+
+        NAPYS_CHECK(value && inserted);
+        *value = i;
+    }
+
+    NAPYS_CHECK(map->count == HASHMAP_TEST_KEYS);
+    NAPYS_CHECK(map->capacity > initial_capacity);
+    NAPYS_CHECK((map->capacity & (map->capacity - 1)) == 0);
+    NAPYS_CHECK(map->count < map->capacity);
+
+    // Every value survives the moves made by resizing
+    for (int i = 0; i < HASHMAP_TEST_KEYS; i++)
+    {
+        SDL_snprintf(key, sizeof(key), "key%d", i);
+
+        const int *value = NapysHashmapFind(map, key);
+
+        NAPYS_CHECK(value && *value == i);
+    }
+
+    // Replacing after resizing does not add entries
+    bool inserted = true;
+    int *value = NapysHashmapInsert(map, "key42", &inserted);
+
+    NAPYS_CHECK(value && !inserted && *value == 42);
+    NAPYS_CHECK(map->count == HASHMAP_TEST_KEYS);
+
+    int sum[2] = {0, 0};
+    NapysIterateHashmap(map, CountEntry, sum);
+
+    NAPYS_CHECK(sum[0] == HASHMAP_TEST_KEYS);
+    NAPYS_CHECK(sum[1] == HASHMAP_TEST_KEYS * (HASHMAP_TEST_KEYS - 1) / 2);
+
+    NapysDestroyHashmap(map);
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const NapysTest tests[] = {
+        NAPYS_TEST(TestInsertAndFind),
+        NAPYS_TEST(TestReplace),
+        NAPYS_TEST(TestResize),
+    };
+
+    return NapysRunTests(tests, SDL_arraysize(tests));
+}
@@ -0,0 +1,142 @@
+#include "napys_test.h"
+
+/**
+ * Check that a command of a list has the expected type and data (NULL for commands without data).
+ */
+static bool CheckCommand(const NapysCommandList *list, int index, NapysCommandType type, const char *data)
+{
+    if (index >= list->cmd_count || list->cmds[index].type != type)
+    {
+        return false;
+    }
+
+    if (!data || !list->cmds[index].data)
+    {
+        return data == list->cmds[index].data;
+    }
+
+    return SDL_strcmp(list->cmds[index].data, data) == 0;
+}
+
+static bool TestPlainText(void)
+{
+    NapysCommandList *list = NapysParseRichText("Hello World", NULL);
+
+    NAPYS_CHECK(list);
+    NAPYS_CHECK(list->cmd_count == 1);
+    NAPYS_CHECK(CheckCommand(list, 0, NAPYS_COMMAND_TYPE_DRAW_TEXT, "Hello World"));
+
+    NapysDestroyCommandList(list);
+
+    list = NapysParseRichText("", NULL);
+
+    NAPYS_CHECK(list);
+    NAPYS_CHECK(list->cmd_count == 0);
+
+    NapysDestroyCommandList(list);
+
+    return true;
+}
+
+static bool TestTrailingText(void)
+{
+    NapysCommandList *list = NapysParseRichText("Gold: {{color:gold}}100{{:newline}}left", NULL);
+
+    NAPYS_CHECK(list);
+    NAPYS_CHECK(list->cmd_count == 5);
+    NAPYS_CHECK(CheckCommand(list, 0, NAPYS_COMMAND_TYPE_DRAW_TEXT, "Gold: "));
+    NAPYS_CHECK(CheckCommand(list, 1, NAPYS_COMMAND_TYPE_SET_COLOR, "gold"));
+    NAPYS_CHECK(CheckCommand(list, 2, NAPYS_COMMAND_TYPE_DRAW_TEXT, "100"));
+    NAPYS_CHECK(CheckCommand(list, 3, NAPYS_COMMAND_TYPE_NEWLINE, NULL));
+    NAPYS_CHECK(CheckCommand(list, 4, NAPYS_COMMAND_TYPE_DRAW_TEXT, "left"));
+
+    NapysDestroyCommandList(list);
+
+    return true;
+}
+
+static bool TestLoneBraces(void)
+{
+    NapysCommandList *list = NapysParseRichText("{", NULL);
+
+    NAPYS_CHECK(list);
+    NAPYS_CHECK(list->cmd_count == 1);
+    NAPYS_CHECK(CheckCommand(list, 0, NAPYS_COMMAND_TYPE_DRAW_TEXT, "{"));
+
+    NapysDestroyCommandList(list);
+
+    // Single braces and a right tag without a left one are plain text
+    list = NapysParseRichText("a { b } c}}d", NULL);
+
+    NAPYS_CHECK(list);
+    NAPYS_CHECK(list->cmd_count == 1);
+    NAPYS_CHECK(CheckCommand(list, 0, NAPYS_COMMAND_TYPE_DRAW_TEXT, "a { b } c}}d"));
+
+    NapysDestroyCommandList(list);
+
+    return true;
+}
+
+static bool TestUnmatchedTag(void)
+{
+    NAPYS_CHECK(!NapysParseRichText("text {{color:red", NULL));
+    NAPYS_CHECK(!NapysParseRichText("{{", NULL));
+
+    return true;
+}
+
+static bool TestEmptyTags(void)
+{
+    // An empty tag uses the string registered under the empty name, which is usually not registered
+    NapysCommandList *list = NapysParseRichText("a{{}}b", NULL);
+
+    NAPYS_CHECK(list);
+    NAPYS_CHECK(list->cmd_count == 3);
+    NAPYS_CHECK(CheckCommand(list, 0, NAPYS_COMMAND_TYPE_DRAW_TEXT, "a"));
+    NAPYS_CHECK(CheckCommand(list, 1, NAPYS_COMMAND_TYPE_USE_STRING, ""));
+    NAPYS_CHECK(CheckCommand(list, 2, NAPYS_COMMAND_TYPE_DRAW_TEXT, "b"));
+
+    NapysDestroyCommandList(list);
+
+    list = NapysParseRichText("{{color:}}", NULL);
+
+    NAPYS_CHECK(list);
+    NAPYS_CHECK(list->cmd_count == 1);
+    NAPYS_CHECK(CheckCommand(list, 0, NAPYS_COMMAND_TYPE_SET_COLOR, ""));
+
+    NapysDestroyCommandList(list);
+
+    return true;
+}
+
+static bool TestCustomTags(void)
+{
+    const NapysRichTextOptions options = {"<", ">", true};
+
+    NapysCommandList *list = NapysParseRichText("<size:big>{{name}}\n<image:icon>", &options);
+
+    NAPYS_CHECK(list);
+    NAPYS_CHECK(list->cmd_count == 4);
+    NAPYS_CHECK(CheckCommand(list, 0, NAPYS_COMMAND_TYPE_SET_SIZE, "big"));
+    NAPYS_CHECK(CheckCommand(list, 1, NAPYS_COMMAND_TYPE_DRAW_TEXT, "{{name}}"));
+    NAPYS_CHECK(CheckCommand(list, 2, NAPYS_COMMAND_TYPE_NEWLINE, NULL));
+    NAPYS_CHECK(CheckCommand(list, 3, NAPYS_COMMAND_TYPE_DRAW_IMAGE, "icon"));
+
+    NapysDestroyCommandList(list);
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const NapysTest tests[] = {
+        NAPYS_TEST(TestPlainText),
+        NAPYS_TEST(TestTrailingText),
+        NAPYS_TEST(TestLoneBraces),
+        NAPYS_TEST(TestUnmatchedTag),
+        NAPYS_TEST(TestEmptyTags),
+        NAPYS_TEST(TestCustomTags),
+    };
+
+    return NapysRunTests(tests, SDL_arraysize(tests));
+}
@@ -0,0 +1,187 @@
+#include <stdio.h>
+
+#include <SDL3/SDL.h>
+
+#include <napys.h>
+
+/**
+ * Offline converter compiling a directory of rich text files into a command pack.
+ *
+ * Every file becomes one command list, named by its path relative to the directory without the extension,
+ * e.g. "menu/start.txt" is stored as "menu/start" and found with NapysFindCommandPackList().
+ */
+
+typedef struct
+{
+    NapysCommandList **lists;
+    char **names;
+    int count;
+} PackInput;
+
+static void Usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [--newlines] [--tags LEFT RIGHT] <markup directory> <output pack>\n", program);
+}
+
+static char *GetListName(const char *relative_path)
+{
+    char *name = SDL_strdup(relative_path);
+
+    if (!name)
+    {
+        return NULL;
+    }
+
+    char *extension = SDL_strrchr(name, '.');
+    char *last_slash = SDL_strrchr(name, '/');
+
+    if (extension && extension > name && (!last_slash || extension > last_slash + 1))
+    {
+        *extension = '\0';
+    }
+
+    return name;
+}
+
+static bool LoadMarkupDirectory(const char *directory, const NapysRichTextOptions *options, PackInput *input)
+{
+    int paths_count = 0;
+    char **paths = SDL_GlobDirectory(directory, NULL, 0, &paths_count);
+
+    if (!paths)
+    {
+        fprintf(stderr, "Failed to list %s: %s\n", directory, SDL_GetError());
+        return false;
+    }
+
+    input->lists = SDL_calloc(paths_count > 0 ? paths_count : 1, sizeof(NapysCommandList *));
+    input->names = SDL_calloc(paths_count > 0 ? paths_count : 1, sizeof(char *));
+
+    bool result = input->lists && input->names;
+
+    for (int i = 0; result && i < paths_count; i++)
+    {
+        char full_path[4096];
+        SDL_snprintf(full_path, sizeof(full_path), "%s/%s", directory, paths[i]);
+
+        SDL_PathInfo info;
+
+        if (!SDL_GetPathInfo(full_path, &info) || info.type != SDL_PATHTYPE_FILE)
+        {
+            continue;
+        }
+
+        char *text = SDL_LoadFile(full_path, NULL);
+
+        if (!text)
+        {
+            fprintf(stderr, "Failed to read %s: %s\n", full_path, SDL_GetError());
+            result = false;
+            break;
+        }
+
+        NapysCommandList *list = NapysParseRichText(text, options);
+        SDL_free(text);
+
+        char *name = list ? GetListName(paths[i]) : NULL;
+
+        if (!name)
+        {
+            fprintf(stderr, "Failed to parse %s: %s\n", full_path, NapysGetError());
+            NapysDestroyCommandList(list);
+            result = false;
+            break;
+        }
+
+        input->lists[input->count] = list;
+        input->names[input->count] = name;
+        input->count++;
+    }
+
+    SDL_free(paths);
+
+    return result;
+}
+
+static void DestroyPackInput(PackInput *input)
+{
+    for (int i = 0; i < input->count; i++)
+    {
+        NapysDestroyCommandList(input->lists[i]);
+        SDL_free(input->names[i]);
+    }
+
+    SDL_free(input->lists);
+    SDL_free(input->names);
+}
+
+int main(int argc, char *argv[])
+{
+    NapysRichTextOptions options = {NULL, NULL, false};
+    const char *directory = NULL;
+    const char *output = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--newlines") == 0)
+        {
+            options.treat_newline_chars_as_commands = true;
+        }
+        else if (SDL_strcmp(argv[i], "--tags") == 0 && i + 2 < argc)
+        {
+            options.left_tag = argv[++i];
+            options.right_tag = argv[++i];
+        }
+        else if (!directory)
+        {
+            directory = argv[i];
+        }
+        else if (!output)
+        {
+            output = argv[i];
+        }
+        else
+        {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!directory || !output)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    PackInput input = {0};
+
+    if (!LoadMarkupDirectory(directory, &options, &input))
+    {
+        DestroyPackInput(&input);
+        return 1;
+    }
+
+    SDL_IOStream *dst = SDL_IOFromFile(output, "wb");
+
+    if (!dst)
+    {
+        fprintf(stderr, "Failed to open %s: %s\n", output, SDL_GetError());
+        DestroyPackInput(&input);
+        return 1;
+    }
+
+    const bool saved = NapysSaveCommandLists(dst, input.lists, (const char *const *)input.names, input.count);
+
+    if (!SDL_CloseIO(dst) || !saved)
+    {
+        fprintf(stderr, "Failed to write %s: %s\n", output, saved ? SDL_GetError() : NapysGetError());
+        DestroyPackInput(&input);
+        return 1;
+    }
+
+    printf("Packed %d texts into %s\n", input.count, output);
+
+    DestroyPackInput(&input);
+
+    return 0;
+}